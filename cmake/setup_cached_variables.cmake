@@ -82,6 +82,11 @@ OPTION(D2K_ENABLE_TESTING
   OFF
   )
 
+OPTION(D2K_WITH_PROFILING
+  "Time the most expensive sections of the library with the profiler of deal2lkit/profiler.h."
+  OFF
+  )
+
 
 ########################################################################
 #                                                                      #
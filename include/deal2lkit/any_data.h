@@ -22,6 +22,7 @@
 #include <deal.II/base/subscriptor.h>
 
 #include <boost/any.hpp>
+#include <functional>
 #include <vector>
 #include <algorithm>
 #include <typeinfo>
@@ -123,6 +124,16 @@ public:
   template <class STREAM>
   void print_info (STREAM &os);
 
+  /**
+   * @brief Estimate the memory used by this object
+   *
+   * The copies are counted with their own size and, for std::vector
+   * objects, the size of their elements. Memory owned by the copies
+   * through pointers, e.g., the derivatives of Sacado types, is not
+   * counted, nor are the objects stored by reference.
+   */
+  std::size_t memory_consumption () const;
+
   /// An entry with this name does not exist in the AnyData object.
   DeclException1(ExcNameNotFound, std::string,
                  << "No entry with the name " << arg1 << " exists.");
@@ -136,13 +147,31 @@ public:
 
 
 private:
+  /**
+   * Memory of an object, and of the elements of a std::vector.
+   */
+  template <typename type>
+  static std::size_t estimate_memory (const type &entry);
+
+  template <typename type>
+  static std::size_t estimate_memory (const std::vector<type> &entry);
+
   std::map<std::string, boost::any> mydata;
+
+  /**
+   * Functions returning the memory of each copy, which know its type.
+   */
+  std::map<std::string, std::function<std::size_t(const boost::any &)> > memory;
 }; // end class
 
 template <typename type>
 void AnyData::add_copy (const type &entry, const std::string &name)
 {
   mydata[name] = entry;
+  memory[name] = [] (const boost::any &a)
+  {
+    return estimate_memory(*boost::any_cast<type>(&a));
+  };
 }
 
 template <typename type>
@@ -150,6 +179,7 @@ void AnyData::add_ref (type &entry, const std::string &name)
 {
   type *ptr = &entry;
   mydata[name] = ptr;
+  memory.erase(name);
 }
 
 template <typename type>
@@ -212,6 +242,35 @@ bool AnyData::have(const std::string &name) const
   return mydata.find(name) != mydata.end();
 }
 
+template <typename type>
+std::size_t AnyData::estimate_memory (const type &)
+{
+  return sizeof(type);
+}
+
+template <typename type>
+std::size_t AnyData::estimate_memory (const std::vector<type> &entry)
+{
+  std::size_t bytes = sizeof(entry) + (entry.capacity()-entry.size())*sizeof(type);
+  for (unsigned int i=0; i<entry.size(); ++i)
+    bytes += estimate_memory(entry[i]);
+  return bytes;
+}
+
+inline
+std::size_t AnyData::memory_consumption () const
+{
+  std::size_t bytes = sizeof(*this);
+  for (auto it = mydata.begin(); it != mydata.end(); ++it)
+    {
+      bytes += sizeof(*it) + it->first.capacity();
+      auto m = memory.find(it->first);
+      if (m != memory.end())
+        bytes += m->second(it->second);
+    }
+  return bytes;
+}
+
 template <class STREAM>
 inline
 void AnyData::print_info(STREAM &os)
@@ -0,0 +1,174 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#ifndef _d2k_checkpoint_utilities_h
+#define _d2k_checkpoint_utilities_h
+
+#include <deal2lkit/config.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/index_set.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/lac/vector.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace dealii;
+
+D2K_NAMESPACE_OPEN
+
+/**
+ * Functions to write and read binary checkpoints of time integrators.
+ *
+ * Every process writes its own file, named after a common prefix and
+ * its rank, containing a header, some scalar values and the locally
+ * owned entries of a set of vectors. A checkpoint can therefore only
+ * be read back with the same number of processes and the same
+ * partitioning of the vectors.
+ *
+ * Files are first written with a temporary name, and renamed by
+ * commit() once all processes are done, so that an interrupted run
+ * never leaves a corrupted file behind. Since each process renames its
+ * own file, a run interrupted during commit() may leave files of two
+ * different checkpoints: the header of each file contains the id of
+ * its checkpoint, e.g., the step number, and read_header() checks that
+ * all processes read the same checkpoint.
+ */
+namespace CheckpointUtilities
+{
+  /**
+   * Name of the checkpoint file of this process. If @p temporary is
+   * true, return the name used while writing.
+   */
+  std::string get_file_name(const std::string &prefix,
+                            const MPI_Comm comm,
+                            const bool temporary=false);
+
+  /**
+   * Return true if the checkpoint file of this process exists on all
+   * processes.
+   */
+  bool exists(const std::string &prefix,
+              const MPI_Comm comm);
+
+  /**
+   * Write a header made of @p tag, the @p version of the format of the
+   * file, the number of processes and the @p id of the checkpoint,
+   * which must be the same on all processes.
+   */
+  void write_header(std::ostream &out,
+                    const std::string &tag,
+                    const unsigned int version,
+                    const unsigned long int id,
+                    const MPI_Comm comm);
+
+  /**
+   * Read the header written by write_header(), and throw an exception
+   * if the tag, the version or the number of processes do not match,
+   * or if the processes read files of different checkpoints. Return
+   * the id of the checkpoint. This function is collective.
+   */
+  unsigned long int read_header(std::istream &in,
+                                const std::string &tag,
+                                const unsigned int version,
+                                const MPI_Comm comm);
+
+  /**
+   * Wait for all processes, and rename the temporary files to their
+   * final name.
+   */
+  void commit(const std::string &prefix,
+              const MPI_Comm comm);
+
+  /**
+   * Return true, on all processes, if more than @p interval seconds of
+   * wall time have elapsed since @p last on any process. In this case
+   * @p last is reset to the current time. A non positive interval
+   * disables the check.
+   */
+  bool interval_elapsed(std::chrono::steady_clock::time_point &last,
+                        const double interval,
+                        const MPI_Comm comm);
+
+  /**
+   * Write a plain value.
+   */
+  template<typename T>
+  void write_value(std::ostream &out, const T &value)
+  {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  /**
+   * Read a plain value.
+   */
+  template<typename T>
+  void read_value(std::istream &in, T &value)
+  {
+    in.read(reinterpret_cast<char *>(&value), sizeof(T));
+    AssertThrow(in, ExcMessage("Error reading a checkpoint file."));
+  }
+
+  /**
+   * Write the locally owned entries of @p vector.
+   */
+  template<typename VEC>
+  void write_vector(std::ostream &out, const VEC &vector)
+  {
+    const IndexSet locally_owned = vector.locally_owned_elements();
+    const unsigned long int n = locally_owned.n_elements();
+    write_value(out, (unsigned long int)vector.size());
+    write_value(out, n);
+
+    std::vector<double> values;
+    values.reserve(n);
+    for (auto i : locally_owned)
+      values.push_back(vector(i));
+    if (n > 0)
+      out.write(reinterpret_cast<const char *>(&values[0]), n*sizeof(double));
+  }
+
+  /**
+   * Read the locally owned entries of @p vector, which must already
+   * have the same layout of the vector that was written.
+   */
+  template<typename VEC>
+  void read_vector(std::istream &in, VEC &vector)
+  {
+    const IndexSet locally_owned = vector.locally_owned_elements();
+    unsigned long int size, n;
+    read_value(in, size);
+    read_value(in, n);
+    AssertThrow(size == vector.size() && n == locally_owned.n_elements(),
+                ExcMessage("The layout of the vectors in the checkpoint does "
+                           "not match the one of the current vectors."));
+
+    std::vector<double> values(n);
+    if (n > 0)
+      in.read(reinterpret_cast<char *>(&values[0]), n*sizeof(double));
+    AssertThrow(in, ExcMessage("Error reading a checkpoint file."));
+
+    unsigned int j=0;
+    for (auto i : locally_owned)
+      vector(i) = values[j++];
+    vector.compress(VectorOperation::insert);
+  }
+}
+
+D2K_NAMESPACE_CLOSE
+
+#endif
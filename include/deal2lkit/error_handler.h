@@ -47,6 +47,7 @@ DEAL_II_ENABLE_EXTRA_DIAGNOSTICS
 #include <deal.II/numerics/data_out.h>
 #include <deal.II/fe/mapping_q.h>
 #include <deal.II/fe/fe.h>
+#include <deal.II/fe/fe_values.h>
 
 #include <deal.II/base/parameter_handler.h>
 #include <deal.II/base/conditional_ostream.h>
@@ -150,7 +151,27 @@ public:
       to the condition of ConditionalOStream &pcout */
   void output_table(ConditionalOStream &pcout, const unsigned int table_no=0);
 
+  /** Return an estimate of the memory used by this object. The content
+      of the tables is not included, since TableHandler does not report
+      its memory consumption. */
+  std::size_t memory_consumption() const;
+
 private:
+  /** Compute in a single loop over the cells the Linfty, L2, W1infty
+      and H1 errors of each component whose @p norms are set, with the
+      same definitions and quadrature of
+      VectorTools::integrate_difference(). The exact solution and its
+      gradient are evaluated once per quadrature point, and the
+      gradients only if some component needs them. The errors are
+      stored in @p error, in the order Linfty, L2, W1infty, H1. */
+  template<typename DH, typename VEC>
+  void integrate_errors(const Mapping<DH::dimension,DH::space_dimension> &mapping,
+                        const DH &vspace,
+                        const VEC &solution,
+                        const Function<DH::space_dimension> &exact,
+                        const std::vector<NormFlags> &norms,
+                        std::vector<std::vector<double> > &error) const;
+
   /** Value of solution names. */
   const std::string solution_names;
 
@@ -310,8 +331,6 @@ void ErrorHandler<ntables>::error_from_exact(const Mapping<DH::dimension, DH::sp
                                              unsigned int table_no,
                                              double dt)
 {
-  const int dim=DH::dimension;
-  const int spacedim=DH::space_dimension;
   if (compute_error)
     {
       AssertThrow(initialized, ExcNotInitialized());
@@ -342,117 +361,37 @@ void ErrorHandler<ntables>::error_from_exact(const Mapping<DH::dimension, DH::sp
           tables[table_no].set_tex_format("dt", "r");
         }
 
-      bool compute_Linfty = false;
-      bool compute_L2 = false;
-      bool compute_W1infty = false;
-      bool compute_H1 = false;
-      bool add_this = false;
-
+      // The norms computed for each component. A component with the
+      // add bit set uses the norms of the last one without it.
+      std::vector<NormFlags> norms(exact.n_components, None);
       unsigned int last_non_add = 0;
-
       for (unsigned int component=0; component < exact.n_components; ++component)
         {
-          NormFlags norm = types[table_no][component];
-
-          // Select one Component
-          ComponentSelectFunction<spacedim> select_component ( component, 1. , exact.n_components);
-
-          Vector<float> difference_per_cell (dh.get_triangulation().n_global_active_cells());
-
-          QGauss<dim> q_gauss((dh.get_fe().degree+1) * 2);
-
-          // The add bit is set
-          add_this = (norm & AddUp);
-
-          if (!add_this)
-            {
-              last_non_add  = component;
-              compute_L2  = ( norm & L2 );
-              compute_H1  = ( norm & H1 );
-              compute_W1infty = ( norm & W1infty ) ;
-              compute_Linfty  = ( norm & Linfty );
-            }
-          // if add is set, we do not modify the previous selection
-
-          if (compute_L2)
-            {
-              VectorTools::integrate_difference (
-                mapping,
-                dh,
-                solution,
-                exact,
-                difference_per_cell,
-                q_gauss,
-                VectorTools::L2_norm,
-                &select_component );
-            }
-
-          const double L2_error = difference_per_cell.l2_norm();
-          difference_per_cell = 0;
-
-          if (compute_H1)
-            {
-              VectorTools::integrate_difference (
-                mapping,
-                dh, //dof_handler,
-                solution,
-                exact,
-                difference_per_cell,
-                q_gauss,
-                VectorTools::H1_norm,
-                &select_component );
-            }
-          const double H1_error = difference_per_cell.l2_norm();
-          difference_per_cell = 0;
-
-          if (compute_W1infty)
+          if (types[table_no][component] & AddUp)
             {
-              VectorTools::integrate_difference (
-                mapping,
-                dh, //dof_handler,
-                solution,
-                exact,
-                difference_per_cell,
-                q_gauss,
-                VectorTools::W1infty_norm,
-                &select_component );
-            }
-
-          const double W1inf_error = difference_per_cell.linfty_norm();
-
-          if (compute_Linfty)
-            {
-              VectorTools::integrate_difference (
-                mapping,
-                dh, //dof_handler,
-                solution,
-                exact,
-                difference_per_cell,
-                q_gauss,
-                VectorTools::Linfty_norm,
-                &select_component );
+              AssertThrow(component, ExcMessage("Cannot add on first component!"));
             }
+          else
+            last_non_add = component;
+          norms[component] = types[table_no][last_non_add];
+        }
 
-          const double Linf_error = difference_per_cell.linfty_norm();
+      std::vector< std::vector<double> > component_error( exact.n_components, std::vector<double>(4));
+      integrate_errors(mapping, dh, solution, exact, norms, component_error);
 
-          if (add_this)
+      for (unsigned int component=0; component < exact.n_components; ++component)
+        {
+          if (types[table_no][component] & AddUp)
             {
-              AssertThrow(component, ExcMessage("Cannot add on first component!"));
-
-              error[last_non_add][0] = std::max(error[last_non_add][0], Linf_error);
-              error[last_non_add][1] += L2_error;
-              error[last_non_add][2] = std::max(error[last_non_add][2], W1inf_error);
-              error[last_non_add][3] += H1_error;
-
+              error[last_non_add][0] = std::max(error[last_non_add][0], component_error[component][0]);
+              error[last_non_add][1] += component_error[component][1];
+              error[last_non_add][2] = std::max(error[last_non_add][2], component_error[component][2]);
+              error[last_non_add][3] += component_error[component][3];
             }
           else
             {
-
-              error[component][0] = Linf_error;
-              error[component][1] = L2_error;
-              error[component][2] = W1inf_error;
-              error[component][3] = H1_error;
-
+              last_non_add = component;
+              error[component] = component_error[component];
             }
         }
 
@@ -522,6 +461,107 @@ void ErrorHandler<ntables>::error_from_exact(const Mapping<DH::dimension, DH::sp
 
 
 
+template <int ntables>
+template<typename DH, typename VEC>
+void ErrorHandler<ntables>::integrate_errors(const Mapping<DH::dimension, DH::space_dimension> &mapping,
+                                             const DH &dh,
+                                             const VEC &solution,
+                                             const Function<DH::space_dimension> &exact,
+                                             const std::vector<NormFlags> &norms,
+                                             std::vector<std::vector<double> > &error) const
+{
+  const int dim=DH::dimension;
+  const int spacedim=DH::space_dimension;
+  const unsigned int n_components = exact.n_components;
+
+  bool need_values = false;
+  bool need_gradients = false;
+  for (unsigned int c=0; c<n_components; ++c)
+    {
+      need_values |= (norms[c] != None);
+      need_gradients |= bool(norms[c] & (H1 | W1infty));
+    }
+
+  for (unsigned int c=0; c<n_components; ++c)
+    std::fill(error[c].begin(), error[c].end(), 0.0);
+  if (!need_values)
+    return;
+
+  QGauss<dim> q_gauss((dh.get_fe().degree+1) * 2);
+  const unsigned int n_q_points = q_gauss.size();
+
+  UpdateFlags flags = update_values | update_quadrature_points | update_JxW_values;
+  if (need_gradients)
+    flags = flags | update_gradients;
+  FEValues<dim,spacedim> fe_values(mapping, dh.get_fe(), q_gauss, flags);
+
+  std::vector<Vector<double> > values(n_q_points, Vector<double>(n_components));
+  std::vector<Vector<double> > exact_values(n_q_points, Vector<double>(n_components));
+  std::vector<std::vector<Tensor<1,spacedim> > >
+  gradients(n_q_points, std::vector<Tensor<1,spacedim> >(n_components));
+  std::vector<std::vector<Tensor<1,spacedim> > >
+  exact_gradients(n_q_points, std::vector<Tensor<1,spacedim> >(n_components));
+
+  // Squares of the L2 error and of the H1 seminorm of the error
+  std::vector<double> L2_squared(n_components, 0.0);
+  std::vector<double> H1_semi_squared(n_components, 0.0);
+
+  typename DH::active_cell_iterator
+  cell = dh.begin_active(),
+  endc = dh.end();
+  for (; cell != endc; ++cell)
+    if (cell->is_locally_owned())
+      {
+        fe_values.reinit(cell);
+        fe_values.get_function_values(solution, values);
+        exact.vector_value_list(fe_values.get_quadrature_points(), exact_values);
+        if (need_gradients)
+          {
+            fe_values.get_function_gradients(solution, gradients);
+            exact.vector_gradient_list(fe_values.get_quadrature_points(), exact_gradients);
+          }
+
+        for (unsigned int c=0; c<n_components; ++c)
+          {
+            if (norms[c] == None)
+              continue;
+
+            const bool with_gradients = (norms[c] & (H1 | W1infty));
+            double cell_Linfty = 0;
+            double cell_gradient_Linfty = 0;
+            for (unsigned int q=0; q<n_q_points; ++q)
+              {
+                const double e = exact_values[q](c) - values[q](c);
+                L2_squared[c] += e*e*fe_values.JxW(q);
+                cell_Linfty = std::max(cell_Linfty, std::abs(e));
+                if (with_gradients)
+                  {
+                    const Tensor<1,spacedim> g = exact_gradients[q][c] - gradients[q][c];
+                    H1_semi_squared[c] += g.norm_square()*fe_values.JxW(q);
+                    cell_gradient_Linfty = std::max(cell_gradient_Linfty, g.norm());
+                  }
+              }
+
+            // As in VectorTools, the W1infty error of a cell is the sum
+            // of the maxima of the error and of its gradient
+            error[c][0] = std::max(error[c][0], cell_Linfty);
+            error[c][2] = std::max(error[c][2], cell_Linfty + cell_gradient_Linfty);
+          }
+      }
+
+  for (unsigned int c=0; c<n_components; ++c)
+    {
+      if (!(norms[c] & Linfty))
+        error[c][0] = 0;
+      error[c][1] = (norms[c] & L2) ? std::sqrt(L2_squared[c]) : 0;
+      if (!(norms[c] & W1infty))
+        error[c][2] = 0;
+      error[c][3] = (norms[c] & H1) ? std::sqrt(L2_squared[c] + H1_semi_squared[c]) : 0;
+    }
+}
+
+
+
 template <int ntables>
 template<typename DH>
 void ErrorHandler<ntables>::custom_error(const std::function<double(const unsigned int component)> &custom_error_function,
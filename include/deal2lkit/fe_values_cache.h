@@ -18,9 +18,11 @@
 
 #include <deal2lkit/config.h>
 #include <deal.II/fe/fe_values.h>
+#include <deal.II/base/memory_consumption.h>
 #include <deal2lkit/any_data.h>
 #include <deal2lkit/dof_utilities.h>
 #include <deal2lkit/utilities.h>
+#include <deal2lkit/profiler.h>
 
 D2K_NAMESPACE_OPEN
 /**
@@ -137,6 +139,7 @@ public:
    */
   void reinit(const typename DoFHandler<dim,spacedim>::active_cell_iterator &cell)
   {
+    D2K_INTERNAL_PROFILE_SCOPE("FEValuesCache reinit");
     fe_values.reinit(cell);
     cell->get_dof_indices(local_dof_indices);
     cache.template add_ref<FEValuesBase<dim,spacedim> >(fe_values, "FEValuesBase");
@@ -150,6 +153,7 @@ public:
   void reinit(const typename DoFHandler<dim,spacedim>::active_cell_iterator &cell,
               const unsigned int face_no)
   {
+    D2K_INTERNAL_PROFILE_SCOPE("FEValuesCache reinit");
     fe_face_values.reinit(cell, face_no);
     cell->get_dof_indices(local_dof_indices);
     cache.template add_ref<FEValuesBase<dim,spacedim> >(fe_face_values, "FEValuesBase");
@@ -163,6 +167,7 @@ public:
   void reinit(const typename DoFHandler<dim,spacedim>::active_cell_iterator &cell,
               const unsigned int face_no, const unsigned int subface_no)
   {
+    D2K_INTERNAL_PROFILE_SCOPE("FEValuesCache reinit");
     fe_subface_values.reinit(cell, face_no, subface_no);
     cell->get_dof_indices(local_dof_indices);
     cache.template add_ref<FEValuesBase<dim,spacedim> >(fe_subface_values, "FEValuesBase");
@@ -745,6 +750,19 @@ public:
     return ret;
   }
 
+  /**
+   * Return an estimate of the memory used by this object, including the
+   * internal FEValues objects and the cached values.
+   */
+  std::size_t memory_consumption() const
+  {
+    return (fe_values.memory_consumption() +
+            fe_face_values.memory_consumption() +
+            fe_subface_values.memory_consumption() +
+            MemoryConsumption::memory_consumption(local_dof_indices) +
+            cache.memory_consumption());
+  }
+
 private:
 
   AnyData                                           cache;
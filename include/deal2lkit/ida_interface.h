@@ -23,13 +23,17 @@
 #include <deal.II/base/exceptions.h>
 #include <deal.II/base/parameter_handler.h>
 #include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/index_set.h>
+#include <deal.II/base/mpi.h>
 #include <deal.II/lac/vector.h>
 #include <deal.II/lac/vector_view.h>
 
 #ifdef D2K_WITH_SUNDIALS
 
 
+#include <deal2lkit/output_queue.h>
 #include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/sundials_statistics.h>
 
 #include <ida/ida.h>
 #include <ida/ida_spils.h>
@@ -44,8 +48,22 @@
 #include "mpi.h"
 #endif
 
+#include <chrono>
+
 D2K_NAMESPACE_OPEN
 
+template<typename VEC=Vector<double> > class IDAInterface;
+
+namespace internal
+{
+  /**
+   * Statistics of @p solver, which are updated by the callbacks of IDA.
+   * Users query them with IDAInterface::get_statistics().
+   */
+  template<typename VEC>
+  IDAStatistics &callback_statistics(IDAInterface<VEC> &solver);
+}
+
 /** Interface to \sundials IDA library.
  *
  * \dk features an interface for the SUite of Nonlinear and
@@ -64,6 +82,11 @@ D2K_NAMESPACE_OPEN
  *  - solver_should_restart;
  *  - differential_components.
  *
+ * If one of the matrix-free Krylov solvers of IDA is selected in the
+ * parameter file, setup_jacobian and solve_jacobian_system are not
+ * used, and the optional jacobian_vmult, setup_preconditioner and
+ * solve_preconditioner are used instead.
+ *
  * Citing from the \sundials documentation:
  *
  *   Consider a system of Differential-Algebraic Equations written in the
@@ -129,7 +152,7 @@ D2K_NAMESPACE_OPEN
  * its problem class from the SundialsInterface class, and
  * implement all pure virtual methods.
  */
-template<typename VEC=Vector<double> >
+template<typename VEC>
 class IDAInterface : public ParameterAcceptor
 {
 public:
@@ -158,9 +181,15 @@ public:
                          VEC &solution_dot);
 
   /**
-   * Clear internal memory, and start with clean objects. This
-   * function is called when the simulation start and when the mesh is
-   * refined.
+   * (Re)initialize IDA at time @p t, with initial step size @p h. This
+   * function is called when the simulation starts and whenever
+   * solver_should_restart() returns true.
+   *
+   * If the layout of @p y is unchanged since the previous call, the
+   * existing IDA memory and vectors are reused through IDAReInit(), and
+   * all options and linear solver hooks stay installed. Otherwise the
+   * wrapped vectors are updated in place, and the IDA memory is created
+   * again, since its internal vectors have the old size.
    */
   void reset_dae(const double t,
                  VEC &y,
@@ -226,7 +255,74 @@ public:
    */
   std::function<VEC&()> get_local_tolerances;
 
+  /**
+   * Compute the product of the Jacobian \f$J = \partial F/\partial y +
+   * \alpha \partial F/\partial \dot y\f$ with @p src. Used only by the
+   * Krylov linear solvers. The implementation of this function is
+   * optional: if it is not provided, IDA uses a difference quotient
+   * approximation of the product.
+   */
+  std::function<int(const double t,
+                    const VEC &y,
+                    const VEC &y_dot,
+                    const double alpha,
+                    const VEC &src,
+                    VEC &dst)> jacobian_vmult;
+
+  /**
+   * Prepare the preconditioner for the Krylov linear solvers. The
+   * implementation of this function is optional.
+   */
+  std::function<int(const double t,
+                    const VEC &y,
+                    const VEC &y_dot,
+                    const double alpha)> setup_preconditioner;
 
+  /**
+   * Apply the (left) preconditioner to @p rhs. Used only by the Krylov
+   * linear solvers, which are not preconditioned if this function is
+   * not provided.
+   */
+  std::function<int(const double t,
+                    const VEC &y,
+                    const VEC &y_dot,
+                    const double alpha,
+                    const VEC &rhs,
+                    VEC &dst)> solve_preconditioner;
+
+  /**
+   * Evaluate the event functions \f$g_i(t, y, \dot y)\f$, i.e., fill
+   * @p values, which has get_n_events() entries. IDA locates the zeros
+   * of these functions within each step, and solve_dae() stops exactly
+   * at the time of an event and calls solver_should_restart(). When
+   * events are defined, solver_should_restart() is called only at
+   * events, instead of after each output. The implementation of this
+   * function is optional, and it is used only if set_n_events() was
+   * called with a positive number.
+   */
+  std::function<int(const double t,
+                    const VEC &y,
+                    const VEC &y_dot,
+                    std::vector<double> &values)> event_function;
+
+  /**
+   * Set the number of event functions evaluated by event_function().
+   * Zero, the default, disables root finding.
+   */
+  void set_n_events(const unsigned int n);
+
+  /**
+   * Number of event functions.
+   */
+  unsigned int get_n_events() const;
+
+  /**
+   * For each event function, a nonzero value if it has a zero at the
+   * time of the last event: +1 if it is increasing, -1 if it is
+   * decreasing (see IDAGetRootInfo). This can be queried in
+   * solver_should_restart().
+   */
+  const std::vector<int> &get_events_found() const;
 
   /**
    * Set initial time equal to @p t disregarding what is written
@@ -234,8 +330,51 @@ public:
    */
   void set_initial_time(const double &t);
 
+  /**
+   * Wait until the outputs queued by solve_dae() are written. This is
+   * done by solve_dae() before each call to solver_should_restart(),
+   * which can therefore change anything used by output_step(), e.g.,
+   * refine the mesh.
+   */
+  void wait_for_output();
+
+  /**
+   * Vector used to store the result of solve_jacobian_system() before
+   * it is handed back to IDA. It is taken from the VectorPool when
+   * reset_dae() changes the layout of the vectors.
+   */
+  VEC &get_linear_solver_work_vector();
+
+  /**
+   * Statistics of the last call to solve_dae(), accumulated over all
+   * restarts. They are updated after each output interval.
+   */
+  const IDAStatistics &get_statistics() const;
+
+  /**
+   * Statistics of the last output interval only.
+   */
+  const IDAStatistics &get_interval_statistics() const;
+
+  /**
+   * Return an estimate of the memory used by this object and by the
+   * IDA workspace. The vectors taken from the VectorPool are shared
+   * with other objects, and are reported by
+   * VectorPool::memory_consumption().
+   */
+  std::size_t memory_consumption() const;
+
 private:
 
+  friend IDAStatistics &internal::callback_statistics<VEC>(IDAInterface<VEC> &);
+
+  /**
+   * Statistics of the current call to solve_dae(). The callbacks
+   * update the timings and the number of calls; the IDA counters are
+   * read after each output interval.
+   */
+  IDAStatistics statistics;
+
   /**
    * This function is executed at construction time to set the
    * std::function above to trigger an assert if they are not
@@ -243,6 +382,71 @@ private:
    */
   void set_functions_to_trigger_an_assert();
 
+  /**
+   * Return the communicator, or MPI_COMM_WORLD if deal.II was not
+   * configured with MPI.
+   */
+  MPI_Comm get_communicator() const;
+
+  /**
+   * Call output_step(), or queue it with copies of @p solution and
+   * @p solution_dot if the output is asynchronous. The time spent
+   * here, including the copies, is added to statistics.output_step.
+   */
+  void write_output(const double t,
+                    const VEC &solution,
+                    const VEC &solution_dot,
+                    const unsigned int step_number);
+
+  /**
+   * Write the state of the integrator (time, step size, order, BDF
+   * history) and the current solution to the checkpoint files. @p t
+   * and @p next_time are the current and the last output times of
+   * solve_dae().
+   */
+  void save_checkpoint(const double t,
+                       const double next_time,
+                       const unsigned int step_number);
+
+  /**
+   * Read the checkpoint files, if they exist, fill @p solution and
+   * @p solution_dot, and restore the IDA memory so that the
+   * integration continues as if it was never interrupted. Return false
+   * if there is no checkpoint.
+   */
+  bool load_checkpoint(VEC &solution,
+                       VEC &solution_dot,
+                       double &t,
+                       double &next_time,
+                       unsigned int &step_number);
+
+  /**
+   * Interpolate the solution and its time derivative at time @p t,
+   * which must be within the last step taken by IDA.
+   */
+  void interpolate_solution(const double t,
+                            VEC &y,
+                            VEC &y_dot);
+
+  /**
+   * Attach the Krylov linear solver of IDA selected in the parameter
+   * file, and the optional user functions. Return the sum of the IDA
+   * return flags.
+   */
+  int initialize_krylov_solver();
+
+  /**
+   * Read the IDA counters with the IDAGet* functions, and add them to
+   * the counters accumulated before the last restart.
+   */
+  void update_statistics();
+
+  /**
+   * Free the IDA memory, destroy the N_Vector objects used by IDA, and
+   * release the work vector of the linear solver.
+   */
+  void free_vectors();
+
 
   /** Final time. */
   double final_time;
@@ -295,18 +499,72 @@ private:
   /** Use local tolerances when computing absolute tolerance. */
   bool use_local_tolerances;
 
+  /** Interpolate the output instead of stopping at each output time. */
+  bool use_dense_output;
+
+  /** Linear solver: custom, spgmr, spbcgs or sptfqmr. */
+  std::string linear_solver_type;
+
+  /** Maximum dimension of the Krylov subspace. */
+  int max_krylov_dimension;
+
+  /** Maximum number of restarts of GMRES. */
+  int max_gmres_restarts;
+
+  /** Ratio between the linear and nonlinear tolerances. */
+  double krylov_convergence_factor;
+
+  /** Number of event functions. */
+  unsigned int n_events;
+
+  /** Events found at the last stop of IDA. */
+  std::vector<int> events_found;
+
+  /** Wall time, in seconds, between checkpoints. */
+  double checkpoint_interval;
+
+  /** Prefix of the checkpoint files. */
+  std::string checkpoint_file;
+
+  /** Continue from the last checkpoint, if any. */
+  bool resume_from_checkpoint;
+
+  /** Maximum number of outputs written in background, zero if synchronous. */
+  unsigned int max_pending_outputs;
+
+  /** Wall time of the last checkpoint. */
+  std::chrono::steady_clock::time_point last_checkpoint_time;
+
+  /** True while the IDA memory is restored from a checkpoint. */
+  bool resuming;
+
+  /** Format of the statistics: none, table or json. */
+  std::string statistics_format;
+
+  /** Print statistics after each output interval. */
+  bool print_interval_statistics;
+
+  /** Value of the IDA counters at the last restart. */
+  IDAStatistics counters_offset;
+
+  /** Statistics of the last output interval. */
+  IDAStatistics interval_statistics;
+
   /** Ida memory object. */
   void *ida_mem;
 
-  /** Ida solution vector. */
+  /** Ida solution vector. A view of the user solution vector. */
   N_Vector yy;
-  /** Ida solution derivative vector. */
+  /** Ida solution derivative vector. A view of the user vector. */
   N_Vector yp;
   /** Ida absolute tolerances vector. */
   N_Vector abs_tolls;
   /** Ida differential components vector. */
   N_Vector diff_id;
 
+  /** Work vector for solve_jacobian_system(). */
+  shared_ptr<VEC> linear_solver_work_vector;
+
 #ifdef DEAL_II_WITH_MPI
   MPI_Comm communicator;
 #endif
@@ -318,6 +576,14 @@ private:
 
   unsigned int local_system_size;
 
+  /** Locally owned elements of the vectors currently used by IDA. */
+  IndexSet locally_owned_elements;
+
+  /**
+   * Queue of the asynchronous outputs. It is declared last, so that
+   * pending outputs are written before the callbacks are destroyed.
+   */
+  OutputQueue output_queue;
 };
 
 
@@ -22,10 +22,13 @@
 #include <deal.II/base/exceptions.h>
 #include <deal.II/base/parameter_handler.h>
 #include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/function_parser.h>
+#include <deal.II/base/mpi.h>
 
 #ifdef D2K_WITH_SUNDIALS
 #include <deal2lkit/parameter_acceptor.h>
 #include <deal2lkit/kinsol_interface.h>
+#include <deal2lkit/output_queue.h>
 
 #ifdef DEAL_II_WITH_MPI
 #include "mpi.h"
@@ -50,6 +53,14 @@ D2K_NAMESPACE_OPEN
  *  - jacobian_vmult (only for kinsol);
  *  - vector_norm (if kinsol is not used).
  *
+ * The optional explicit_operator splits the problem as
+ * \f$ F(t, y, \dot y) = f_E(t, y) \f$, where \f$ f_E \f$ is treated
+ * explicitly by the IMEX schemes.
+ *
+ * If solve_jacobian_system_with_tolerance is provided, it is used
+ * instead of solve_jacobian_system, and the linear systems of the
+ * Newton method are solved inexactly, with tolerances given by the
+ * Eisenstat-Walker forcing terms.
  */
 template<typename VEC=Vector<double> >
 class IMEXStepper : public ParameterAcceptor
@@ -89,7 +100,8 @@ public:
   /**
    * if initial time is different from final time (i.e.,
    * we are solving a time-dep problem and not a stationay
-   * one, return the inverse of dt. If the problem is
+   * one, return the inverse of dt, times the coefficient of the
+   * current stage of the scheme. If the problem is
    * stationary, returns 0.
    */
   double get_alpha() const;
@@ -100,6 +112,14 @@ public:
    */
   void set_initial_time(const double &t);
 
+  /**
+   * Wait until the outputs queued by solve_dae() are written. This is
+   * done by solve_dae() before each call to solver_should_restart(),
+   * which can therefore change anything used by output_step(), e.g.,
+   * refine the mesh.
+   */
+  void wait_for_output();
+
 private:
 
 #ifdef DEAL_II_WITH_MPI
@@ -115,6 +135,40 @@ private:
   /** Step size. */
   double step_size;
 
+  /**
+   * Coefficient of the time derivative of the current stage, i.e.,
+   * y_dot = alpha_coefficient/step_size*(y - history). It is one for
+   * implicit Euler.
+   */
+  double alpha_coefficient;
+
+  /**
+   * Time stepping scheme: implicit_euler, bdf2, sbdf2, ars222 or
+   * ars443.
+   */
+  std::string scheme;
+
+  /**
+   * Known right hand side of the current stage, collecting the
+   * explicit terms. No right hand side is used if it is empty.
+   */
+  shared_ptr<VEC> stage_rhs;
+
+  /**
+   * Return a vector with the layout of @p model, zero, from the vector
+   * pool shared with KINSOLInterface and IDAInterface. New vectors are
+   * created with create_new_vector().
+   */
+  shared_ptr<VEC> get_vector(const VEC &model);
+
+  /**
+   * Residual of the current stage, i.e., residual() minus stage_rhs.
+   */
+  int stage_residual(const double t,
+                     const VEC &y,
+                     const VEC &y_dot,
+                     VEC &res);
+
   /**
    * user defined step_size
    */
@@ -122,10 +176,62 @@ private:
 
   /**
    * Evaluate step size at time @p t according to the
-   * expression stored in _step_size
+   * expression stored in _step_size. The expression is parsed only
+   * when it changes. With adaptive time stepping, this is the largest
+   * step size allowed.
    */
   double evaluate_step_size(const double &t);
 
+  /**
+   * Parsed expression of the step size, and the string it was
+   * parsed from.
+   */
+  shared_ptr<FunctionParser<1> > step_size_function;
+  std::string parsed_step_size;
+
+  /**
+   * Enable the adaptive control of the step size.
+   */
+  bool use_adaptive_time_stepping;
+
+  /** Tolerances of the local time error. */
+  double abs_time_tol;
+  double rel_time_tol;
+
+  /** Smallest step size of the adaptive controller. */
+  double min_step_size;
+
+  /** Safety factor of the adaptive controller. */
+  double step_safety_factor;
+
+  /** Bounds on the ratio between two consecutive step sizes. */
+  double min_step_ratio;
+  double max_step_ratio;
+
+  /** Maximum number of rejections of a single step. */
+  unsigned int max_step_rejections;
+
+  /**
+   * Estimate of the local error of the implicit Euler step from
+   * @p prev to @p sol, scaled by the tolerances. The estimate is the
+   * difference with the explicit Euler predictor built from
+   * @p prev_dot, which is of lower order. The step is accepted if the
+   * returned value is not larger than one.
+   */
+  double estimate_error(const VEC &sol,
+                        const VEC &prev,
+                        const VEC &prev_dot,
+                        VEC &tmp);
+
+  /**
+   * PI controller: return the step size that follows a step of size
+   * @p dt with scaled error @p error, if the previous step had scaled
+   * error @p previous_error.
+   */
+  double compute_next_step_size(const double dt,
+                                const double error,
+                                const double previous_error) const;
+
   /** Initial time for the ode.*/
   double initial_time;
 
@@ -153,6 +259,30 @@ private:
   /** Jacobian is updated at each outer iteration and time step */
   bool update_jacobian_continuously;
 
+  /**
+   * Keep the Jacobian across Newton iterations and time steps, and
+   * update it only when the convergence rate of the Newton method
+   * exceeds max_convergence_rate, when alpha changes by more than
+   * max_alpha_change, or when it is older than max_jacobian_age
+   * steps. If true, update_jacobian_continuously is ignored.
+   */
+  bool lag_jacobian;
+
+  /** Ratio of two consecutive update norms triggering an update of the Jacobian. */
+  double max_convergence_rate;
+
+  /** Relative change of alpha triggering an update of the Jacobian. */
+  double max_alpha_change;
+
+  /** Maximum number of time steps a Jacobian is used for. */
+  unsigned int max_jacobian_age;
+
+  /** Alpha used in the last call to setup_jacobian(). */
+  double jacobian_alpha;
+
+  /** Number of time steps since the last call to setup_jacobian(). */
+  unsigned int jacobian_age;
+
   /**
    * use kinsol solver true or false
    */
@@ -170,6 +300,84 @@ private:
   /** method used for alpha selection*/
   std::string method;
 
+  /** Choose the linear tolerance with the Eisenstat-Walker forcing terms. */
+  bool use_forcing_terms;
+
+  /** Maximum forcing term, used in the first Newton iteration. */
+  double max_forcing_term;
+
+  /**
+   * Minimum forcing term. It is the linear tolerance when forcing
+   * terms are not used, and in the linear solves of KINSOL.
+   */
+  double min_forcing_term;
+
+  /** Parameter gamma of the Eisenstat-Walker forcing terms. */
+  double forcing_term_gamma;
+
+  /** Exponent of the Eisenstat-Walker forcing terms. */
+  double forcing_term_exponent;
+
+  /** Wall time, in seconds, between checkpoints. */
+  double checkpoint_interval;
+
+  /** Prefix of the checkpoint files. */
+  std::string checkpoint_file;
+
+  /** Continue from the last checkpoint, if any. */
+  bool resume_from_checkpoint;
+
+  /** Maximum number of outputs written in background, zero if synchronous. */
+  unsigned int max_pending_outputs;
+
+  /**
+   * Call output_step(), or queue it with copies of @p solution and
+   * @p solution_dot if the output is asynchronous.
+   */
+  void write_output(const double t,
+                    const VEC &solution,
+                    const VEC &solution_dot,
+                    const unsigned int step_number);
+
+  /**
+   * Return the communicator, or MPI_COMM_WORLD if deal.II was not
+   * configured with MPI.
+   */
+  MPI_Comm get_communicator() const;
+
+  /**
+   * Write the time, the step size, the step number and the current
+   * solution to the checkpoint files, together with the state needed
+   * to continue exactly as without interruption: the previous step
+   * size and, if @p have_older is true, the solution of the previous
+   * step, used by the multistep schemes, and the step size and the
+   * error estimate of the adaptive step size controller.
+   */
+  void save_checkpoint(const double t,
+                       const unsigned int step_number,
+                       const VEC &solution,
+                       const VEC &solution_dot,
+                       const double previous_step_size,
+                       const VEC &older_solution,
+                       const bool have_older,
+                       const double adaptive_step_size,
+                       const double previous_error);
+
+  /**
+   * Read the checkpoint files, if they exist, and fill the arguments
+   * with their content. @p older_solution is filled only if
+   * @p have_older is true. Return false if there is no checkpoint.
+   */
+  bool load_checkpoint(double &t,
+                       unsigned int &step_number,
+                       VEC &solution,
+                       VEC &solution_dot,
+                       double &previous_step_size,
+                       VEC &older_solution,
+                       bool &have_older,
+                       double &adaptive_step_size,
+                       double &previous_error);
+
   /**
    *  Line search algorithm with backtracking. The following sequence
    *  of Newton relaxation parameters is tested: 1, 1/2, 1/4,...,2^-i.
@@ -184,6 +392,48 @@ private:
                                        VEC &sol_dot,
                                        VEC &residual);
 
+  /**
+   * Line search algorithm with quadratic and cubic interpolation.
+   * The full step is tried first, and, if it does not satisfy the
+   * Armijo condition on |F|^2/2, the step length is predicted by the
+   * minimum of a quadratic model, and then of cubic models, of the
+   * merit function. At most n_max_backtracking step lengths are
+   * tested after the full step. @p residual contains the residual at
+   * @p sol on input. It returns the selected alpha, and solution,
+   * solution_dot and residual are accordingly updated.
+   */
+  double line_search_with_interpolation(const VEC &update,
+                                        const VEC &prev_sol,
+                                        const double &alpha,
+                                        const double &t,
+                                        VEC &sol,
+                                        VEC &sol_dot,
+                                        VEC &residual);
+
+
+  /**
+   * Compute the Eisenstat-Walker forcing term of the next Newton
+   * iteration, i.e., the relative tolerance of the next linear solve,
+   * from the norms of the current and of the previous residual and
+   * from the previous forcing term.
+   */
+  double compute_forcing_term(const double res_norm,
+                              const double previous_res_norm,
+                              const double previous_forcing_term) const;
+
+  /**
+   * Return true if the Jacobian that was set up last cannot be used
+   * with the given @p alpha.
+   */
+  bool jacobian_is_outdated(const double alpha) const;
+
+  /**
+   * Call solve_jacobian_system_with_tolerance(), if it is provided,
+   * or solve_jacobian_system().
+   */
+  int solve_linear_system(const VEC &rhs,
+                          VEC &dst,
+                          const double tolerance);
 
   /**
    * find solution applying the newton method with given
@@ -232,6 +482,16 @@ public:
                     const VEC &y_dot,
                     VEC &res)> residual;
 
+  /**
+   * Compute the explicit part \f$ f_E(t, y) \f$ of the problem
+   * \f$ F(t, y, \dot y) = f_E(t, y) \f$, where residual() computes
+   * \f$ F \f$. The implementation of this function is optional: if it
+   * is not provided the problem is treated implicitly.
+   */
+  std::function<int(const double t,
+                    const VEC &y,
+                    VEC &dst)> explicit_operator;
+
   /**
    * Compute Jacobian.
    */
@@ -245,6 +505,20 @@ public:
    */
   std::function<int(const VEC &rhs, VEC &dst)> solve_jacobian_system;
 
+  /**
+   * Solve linear system up to a reduction @p tolerance of the norm
+   * of @p rhs, e.g., by passing it to ParsedSolver::set_reduction().
+   * The tolerance is given by the Eisenstat-Walker forcing terms of
+   * the Newton method, and is loose in the first iterations and
+   * tighter close to convergence.
+   *
+   * The implementation of this function is optional: if it is not
+   * provided, solve_jacobian_system() is used instead.
+   */
+  std::function<int(const VEC &rhs,
+                    VEC &dst,
+                    const double tolerance)> solve_jacobian_system_with_tolerance;
+
   /**
    * Store solutions to file.
    */
@@ -289,6 +563,11 @@ private:
    */
   void set_functions_to_trigger_an_assert();
 
+  /**
+   * Queue of the asynchronous outputs. It is declared last, so that
+   * pending outputs are written before the callbacks are destroyed.
+   */
+  OutputQueue output_queue;
 };
 
 D2K_NAMESPACE_CLOSE
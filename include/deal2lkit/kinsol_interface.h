@@ -31,6 +31,7 @@
 
 #include <deal2lkit/parameter_acceptor.h>
 #include <deal2lkit/utilities.h>
+#include <deal2lkit/sundials_statistics.h>
 
 #ifdef DEAL_II_WITH_MPI
 #include "mpi.h"
@@ -142,6 +143,68 @@ public:
   /** Standard function multiplying the Jacobian to a vector */
   std::function<int(const VEC &v, VEC &dst )> jacobian_vmult;
 
+  /**
+   * Prepare the preconditioner of the Krylov linear solvers at the
+   * current solution @p y. The implementation of this function is
+   * optional.
+   */
+  std::function<int(const VEC &y)> setup_preconditioner;
+
+  /**
+   * Apply the (right) preconditioner to @p rhs. Used only by the
+   * Krylov linear solvers, which are not preconditioned if this
+   * function is not provided.
+   */
+  std::function<int(const VEC &rhs, VEC &dst)> solve_preconditioner;
+
+  /**
+   * Work vectors used by the callbacks to exchange data with KINSOL.
+   */
+  enum WorkVector
+  {
+    work_y,
+    work_residual,
+    work_update,
+    work_jacobian_vmult,
+    n_work_vectors
+  };
+
+  /**
+   * Return the work vector @p i. The work vectors are taken once in
+   * initialize_solver() from the VectorPool, and reused at each
+   * nonlinear iteration.
+   */
+  VEC &get_work_vector(const unsigned int i);
+
+  /**
+   * Return true if the products with the Jacobian needed by the line
+   * search of KINSOL are computed with jacobian_vmult() after each
+   * linear solve. This is not the case if the linear systems are
+   * assumed to be solved exactly, or with the picard strategy.
+   */
+  bool needs_jacobian_vmult() const;
+
+  /**
+   * Statistics of the last call to solve(). Use operator+ to
+   * accumulate them over many solves.
+   */
+  const KINSOLStatistics &get_statistics() const;
+
+  /**
+   * Return an estimate of the memory used by this object and by the
+   * KINSOL workspace. The vectors taken from the VectorPool are shared
+   * with other objects, and are reported by
+   * VectorPool::memory_consumption().
+   */
+  std::size_t memory_consumption() const;
+
+  /**
+   * Statistics of the current call to solve(). The callbacks update
+   * the timings and the number of calls, while the KINSOL counters are
+   * read at the end of solve(). Use get_statistics() to query them.
+   */
+  KINSOLStatistics statistics;
+
 private:
 
   /**
@@ -150,12 +213,27 @@ private:
    */
   void set_functions_to_trigger_an_assert();
 
+  /**
+   * Read the KINSOL counters with the KINGet* functions, and add them
+   * to counters_offset.
+   */
+  void update_statistics();
+
+  /**
+   * Attach the Krylov linear solver of KINSOL selected by
+   * linear_solver_type, and the optional Jacobian product and
+   * preconditioner. Return the sum of the KINSOL return values.
+   */
+  int initialize_krylov_solver();
+
   /** Strategy used by the solver:
    *
    * -   newton        = basic Newton iteration
    * -   global_newton = Newton with line search
-   * -   fixed_point   = fixed-point iteration with Anderson Acceleration
-   * -   picard        = Picard iteration with Anderson Acceleration
+   * -   fixed_point   = fixed-point iteration with Anderson Acceleration,
+   *                     where residual() computes the fixed-point function
+   * -   picard        = Picard iteration with Anderson Acceleration, where
+   *                     setup_jacobian() builds a lagged operator
    *
    */
   std::string strategy;
@@ -163,6 +241,12 @@ private:
   /** Maximum number of iterations */
   unsigned int max_iterations;
 
+  /**
+   * Size of the subspace of the Anderson acceleration, used by the
+   * fixed_point and picard strategies. Zero means no acceleration.
+   */
+  unsigned int anderson_subspace_size;
+
   /**
    * Input scalar tolerance for residuals.
    * This defines the condition (small residual) for a successful completion
@@ -210,6 +294,47 @@ private:
    */
   bool use_internal_solver;
 
+  /**
+   * Linear solver: custom (user callbacks), or one of the Jacobian-free
+   * Krylov solvers of KINSOL (spgmr, spbcgs, sptfqmr).
+   */
+  std::string linear_solver_type;
+
+  /**
+   * Jacobian times vector product of the Krylov solvers:
+   * difference_quotient or user.
+   */
+  std::string jacobian_product;
+
+  /** Maximum dimension of the Krylov subspace. */
+  unsigned int max_krylov_dimension;
+
+  /** Maximum number of restarts of GMRES. */
+  unsigned int max_gmres_restarts;
+
+  /**
+   * If true, the line search quantities of KINSOL are computed
+   * assuming that the Newton step p satisfies J p = -F, which saves a
+   * product with the Jacobian at each iteration.
+   */
+  bool exact_linear_solves;
+
+  /**
+   * Work vectors of the callbacks, see WorkVector.
+   */
+  std::vector<shared_ptr<VEC> > work_vectors;
+
+  /**
+   * Format of the statistics printed after each solve: none, table or
+   * json.
+   */
+  std::string statistics_format;
+
+  /**
+   * Value of the KINSOL counters before the last call to KINSol.
+   */
+  KINSOLStatistics counters_offset;
+
   /**
    * KINSOL solution vector.
    * After initialize_solver is called this contains the initial guess.
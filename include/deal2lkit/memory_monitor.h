@@ -0,0 +1,103 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#ifndef _d2k_memory_monitor_h
+#define _d2k_memory_monitor_h
+
+#include <deal2lkit/config.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/utilities.h>
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace dealii;
+
+D2K_NAMESPACE_OPEN
+
+/**
+ * Keep track of the memory used by a program, to find out which of its
+ * components needs most of it.
+ *
+ * checkpoint() samples the resident set size of the process and its
+ * peak (VmRSS and VmHWM of /proc/self/status), and add_component()
+ * records the memory used by an object, as returned by its
+ * memory_consumption() method. print_summary() prints the minimum,
+ * average and maximum of every entry over the processes.
+ *
+ * @code
+ * MemoryMonitor memory(MPI_COMM_WORLD);
+ * memory.checkpoint("Setup");
+ * assemble_system();
+ * memory.checkpoint("Assembly");
+ * memory.add_component("FEValuesCache", scratch.memory_consumption());
+ * memory.add_component("Vector pool",
+ *                      VectorPool<VEC>::get_pool().memory_consumption());
+ * memory.print_summary(std::cout);
+ * @endcode
+ *
+ * All processes must record the same entries, in the same order.
+ */
+class MemoryMonitor
+{
+public:
+  /**
+   * Constructor. The summary is reduced over @p comm.
+   */
+  MemoryMonitor(const MPI_Comm comm=MPI_COMM_WORLD);
+
+  /**
+   * Sample the memory used by the process at the checkpoint @p name.
+   */
+  void checkpoint(const std::string &name);
+
+  /**
+   * Record that the component @p name uses @p bytes bytes.
+   */
+  void add_component(const std::string &name,
+                     const std::size_t bytes);
+
+  /**
+   * Remove all the entries.
+   */
+  void clear();
+
+  /**
+   * Print, on the first process, a table with the minimum, average and
+   * maximum over the processes of the resident set size and its peak at
+   * each checkpoint, and of the memory of each component, in MB. This
+   * function is collective.
+   */
+  void print_summary(std::ostream &out) const;
+
+private:
+  const MPI_Comm comm;
+
+  /**
+   * Name and memory statistics of each checkpoint.
+   */
+  std::vector<std::pair<std::string, Utilities::System::MemoryStats> > checkpoints;
+
+  /**
+   * Name and bytes of each component.
+   */
+  std::vector<std::pair<std::string, std::size_t> > components;
+};
+
+D2K_NAMESPACE_CLOSE
+
+#endif
@@ -0,0 +1,143 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#ifndef _d2k_output_queue_h
+#define _d2k_output_queue_h
+
+#include <deal2lkit/config.h>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+D2K_NAMESPACE_OPEN
+
+/**
+ * A bounded queue of output tasks, run in order by a background
+ * thread, so that the time integrators can continue while the output
+ * of the previous steps is written.
+ *
+ * Tasks must own what they need, e.g., copies of the solution vectors,
+ * and must not use objects that are modified by the caller until
+ * wait() returns. When the queue holds @p max_pending tasks, push()
+ * blocks until one of them is done. If @p max_pending is zero, tasks
+ * are run immediately by push(), in the calling thread.
+ *
+ * An exception thrown by a task is rethrown by the next call to push()
+ * or wait().
+ *
+ * @code
+ * OutputQueue queue(2);
+ * shared_ptr<VEC> copy = SP(new VEC(solution));
+ * queue.push([&, copy] ()
+ * {
+ *   data_out.prepare_data_output(dof_handler);
+ *   data_out.add_data_vector(*copy, "u");
+ *   data_out.write_data_and_clear();
+ * });
+ * ...
+ * queue.wait();
+ * @endcode
+ *
+ * With MPI, a task that communicates runs concurrently with the
+ * communications of the calling thread, which requires an MPI library
+ * initialized with MPI_THREAD_MULTIPLE. If MPI is initialized with a
+ * lower thread support level, e.g., MPI_THREAD_SERIALIZED as done by
+ * Utilities::MPI::MPI_InitFinalize, the queue is always synchronous.
+ */
+class OutputQueue
+{
+public:
+  /**
+   * Constructor. No thread is started until the first task is pushed.
+   * The maximum number of pending tasks is set as in set_max_pending().
+   */
+  OutputQueue(const unsigned int max_pending=0);
+
+  /**
+   * Destructor. Run the pending tasks and stop the thread. Exceptions
+   * of the tasks are ignored at this point.
+   */
+  ~OutputQueue();
+
+  /**
+   * Wait for the pending tasks, and change the maximum number of them.
+   * The maximum is set to zero if MPI does not support
+   * MPI_THREAD_MULTIPLE.
+   */
+  void set_max_pending(const unsigned int max_pending);
+
+  /**
+   * Return true if tasks are run by the background thread, i.e., if
+   * the maximum number of pending tasks is positive.
+   */
+  bool is_asynchronous() const;
+
+  /**
+   * Add a task to the queue, waiting if it is full.
+   */
+  void push(const std::function<void()> &task);
+
+  /**
+   * Wait until all the tasks are done.
+   */
+  void wait();
+
+  /**
+   * Number of tasks that are queued or running.
+   */
+  unsigned int n_pending() const;
+
+private:
+  /**
+   * Body of the background thread.
+   */
+  void run();
+
+  /**
+   * Rethrow the exception of a task, if any. The mutex must be locked.
+   */
+  void rethrow_exception();
+
+  unsigned int max_pending;
+
+  std::deque<std::function<void()> > tasks;
+
+  /** True while the thread runs a task. */
+  bool busy;
+
+  /** Set by the destructor to stop the thread. */
+  bool stop;
+
+  /** The first exception thrown by a task. */
+  std::exception_ptr exception;
+
+  mutable std::mutex mutex;
+
+  /** Signaled when a task is added, or when the thread must stop. */
+  std::condition_variable task_added;
+
+  /** Signaled when a task is done. */
+  std::condition_variable task_done;
+
+  std::thread worker;
+};
+
+D2K_NAMESPACE_CLOSE
+
+#endif
@@ -89,6 +89,11 @@ public:
       in the @p incremental_run_prefix of the costructor function.*/
   void write_data_and_clear(const Mapping<dim,spacedim> &mapping=StaticMappingQ1<dim,spacedim>::mapping);
 
+  /** Return an estimate of the memory used by this object, including
+      the data added since the last call to prepare_data_output(),
+      which is released by write_data_and_clear(). */
+  std::size_t memory_consumption() const;
+
 private:
   /** Initialization flag.*/
   bool initialized;
@@ -255,6 +255,12 @@ public:
                           std::vector<unsigned int> &indices,
                           std::vector<double> &distances) const;
 
+  /**
+   * Return an estimate of the memory used by the index. The points are
+   * only referenced, and are not counted.
+   */
+  std::size_t memory_consumption() const;
+
 private:
   /**
    * Max number of points per leaf.
@@ -0,0 +1,343 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#ifndef _d2k_parsed_point_probe_h
+#define _d2k_parsed_point_probe_h
+
+#include <deal2lkit/config.h>
+#include <deal2lkit/utilities.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/parsed_kdtree_distance.h>
+
+#include <deal.II/base/point.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/fe/mapping.h>
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/vector.h>
+
+#include <boost/signals2/connection.hpp>
+
+using namespace dealii;
+
+D2K_NAMESPACE_OPEN
+
+/**
+ * Evaluate finite element fields at a (possibly large) collection of
+ * probe points.
+ *
+ * Locating a point in a mesh with GridTools::find_active_cell_around_point()
+ * costs roughly a linear search over the cells for every point. This
+ * class indexes the centers of the active cells and the vertices of
+ * the triangulation in two kdtrees (see ParsedKDTreeDistance), so that
+ * for each probe only a handful of candidate cells need to be checked
+ * by inverting the mapping. The plain deal.II search is used only as a
+ * fallback, when none of the candidates contains the point.
+ *
+ * Once the probes have been located, the cell, the reference
+ * coordinates, the local dof indices and the values of all shape
+ * functions at every probe are cached. Evaluating any number of
+ * solution vectors at all probes is then a sequence of small dot
+ * products, and no FEValues object is reinitialized.
+ *
+ * The cache is invalidated automatically whenever the triangulation
+ * changes (refinement, coarsening, repartitioning), and it is rebuilt
+ * at the next call to evaluate(). If you call
+ * DoFHandler::distribute_dofs() or renumber the degrees of freedom
+ * without touching the mesh, call locate() again yourself.
+ *
+ * In parallel, every probe is assigned to exactly one process (the
+ * one with the lowest rank among those owning a cell containing the
+ * point), and the values returned by evaluate() are summed over all
+ * processes, so that they are identical on each of them. The vectors
+ * passed to evaluate() must give read access to the degrees of freedom
+ * of the locally owned cells, i.e., they must be ghosted.
+ *
+ * The probe points can be given in the parameter file, as a semicolon
+ * separated list of points, or set programmatically with set_points().
+ */
+template<int dim, int spacedim=dim>
+class ParsedPointProbe : public ParameterAcceptor
+{
+public:
+  /**
+   * Constructor. Takes an optional name for the section, an optional
+   * list of probe points, the number of candidate cells to inspect
+   * for each probe, and the maximum number of points per leaf used to
+   * build the kdtrees.
+   */
+  ParsedPointProbe(const std::string &name="",
+                   const std::vector<Point<spacedim> > &points=std::vector<Point<spacedim> >(),
+                   const unsigned int &n_candidate_cells=4,
+                   const unsigned int &max_leaf_size=10,
+                   const MPI_Comm &comm=MPI_COMM_WORLD);
+
+  /**
+   * Disconnect from the triangulation.
+   */
+  ~ParsedPointProbe();
+
+  /**
+   * Declare the parameters of this class.
+   */
+  virtual void declare_parameters(ParameterHandler &prm);
+
+  /**
+   * Invalidate the cache when the probe points are read from file.
+   */
+  virtual void parse_parameters_call_back();
+
+  /**
+   * Set the probe points. This invalidates the cached locations.
+   */
+  void set_points(const std::vector<Point<spacedim> > &points);
+
+  /**
+   * Return the probe points.
+   */
+  const std::vector<Point<spacedim> > &get_points() const;
+
+  /**
+   * Build the kdtrees on the given DoFHandler, locate all probe points,
+   * and cache everything that is needed to evaluate finite element
+   * fields at them. The mapping and the DoFHandler must live longer
+   * than this object, or at least until the next call to this
+   * function.
+   */
+  void locate(const Mapping<dim,spacedim> &mapping,
+              const DoFHandler<dim,spacedim> &dh);
+
+  /**
+   * Same as above, using a MappingQ1.
+   */
+  void locate(const DoFHandler<dim,spacedim> &dh);
+
+  /**
+   * Return true if the cached locations are still valid.
+   */
+  bool is_located() const;
+
+  /**
+   * Return true if the @p i-th probe was found in some cell of the
+   * mesh (of any process).
+   */
+  bool is_found(const unsigned int i) const;
+
+  /**
+   * Return true if the @p i-th probe is evaluated by this process.
+   */
+  bool is_locally_owned(const unsigned int i) const;
+
+  /**
+   * Evaluate all the given vectors at all probe points. On exit
+   * values[v][i] contains all the components of the vector
+   * vectors[v] at the i-th probe. Probes that were not found in the
+   * mesh are set to zero.
+   */
+  template<typename VEC>
+  void evaluate(const std::vector<const VEC *> &vectors,
+                std::vector<std::vector<Vector<double> > > &values);
+
+  /**
+   * Evaluate a single vector at all probe points.
+   */
+  template<typename VEC>
+  void evaluate(const VEC &vector,
+                std::vector<Vector<double> > &values);
+
+private:
+  /**
+   * Called by the triangulation whenever it changes.
+   */
+  void invalidate();
+
+  /**
+   * Collect the candidate cells for the point @p p, in order of
+   * likelihood.
+   */
+  void get_candidate_cells(const Point<spacedim> &p,
+                           std::vector<unsigned int> &candidates) const;
+
+  /**
+   * The probe points.
+   */
+  std::vector<Point<spacedim> > points;
+
+  /**
+   * Number of cells whose center is closest to a probe, which are
+   * inspected before trying the cells around the closest vertex.
+   */
+  unsigned int n_candidate_cells;
+
+  /**
+   * Max number of points per leaf in the kdtrees.
+   */
+  unsigned int max_leaf_size;
+
+  /**
+   * MPI communicator.
+   */
+  const MPI_Comm &comm;
+
+  /**
+   * Mapping used by the last call to locate().
+   */
+  SmartPointer<const Mapping<dim,spacedim> > mapping;
+
+  /**
+   * DoFHandler used by the last call to locate().
+   */
+  SmartPointer<const DoFHandler<dim,spacedim> > dh;
+
+  /**
+   * Connection to the signals of the triangulation.
+   */
+  boost::signals2::connection tria_listener;
+
+  /**
+   * Whether the cache is up to date.
+   */
+  bool located;
+
+  /**
+   * Locally owned active cells, in the same order of the centers.
+   */
+  std::vector<typename DoFHandler<dim,spacedim>::active_cell_iterator> cells;
+
+  /**
+   * Centers of the locally owned active cells.
+   */
+  std::vector<Point<spacedim> > centers;
+
+  /**
+   * Vertices of the locally owned active cells.
+   */
+  std::vector<Point<spacedim> > vertices;
+
+  /**
+   * For each vertex, the indices (in the cells vector) of the cells
+   * sharing it.
+   */
+  std::vector<std::vector<unsigned int> > vertex_to_cells;
+
+  /**
+   * Adaptors and kdtrees for the centers and for the vertices.
+   */
+  shared_ptr<typename ParsedKDTreeDistance<spacedim>::PointCloudAdaptor> centers_adaptor;
+  shared_ptr<typename ParsedKDTreeDistance<spacedim>::KDTree> centers_tree;
+  shared_ptr<typename ParsedKDTreeDistance<spacedim>::PointCloudAdaptor> vertices_adaptor;
+  shared_ptr<typename ParsedKDTreeDistance<spacedim>::KDTree> vertices_tree;
+
+  /**
+   * For each probe, whether it was found on some process.
+   */
+  std::vector<bool> found;
+
+  /**
+   * For each probe, whether this process evaluates it.
+   */
+  std::vector<bool> owned;
+
+  /**
+   * For each probe, the reference coordinates inside its cell.
+   */
+  std::vector<Point<dim> > reference_points;
+
+  /**
+   * For each locally owned probe, the global dof indices of its cell.
+   */
+  std::vector<std::vector<types::global_dof_index> > dof_indices;
+
+  /**
+   * For each locally owned probe, the values of the shape functions
+   * (rows) for each component (columns).
+   */
+  std::vector<FullMatrix<double> > shape_values;
+};
+
+
+
+// ============================================================
+// Template specializations
+// ============================================================
+
+template <int dim, int spacedim>
+template<typename VEC>
+void ParsedPointProbe<dim,spacedim>::evaluate(const std::vector<const VEC *> &vectors,
+                                              std::vector<std::vector<Vector<double> > > &values)
+{
+  AssertThrow(dh, ExcMessage("You have to call locate() before evaluate()."));
+  if (!located)
+    locate(*mapping, *dh);
+
+  const unsigned int n_components = dh->get_fe().n_components();
+  const unsigned int n_probes = points.size();
+  const unsigned int n_vectors = vectors.size();
+
+  // Flatten everything in a single array, so that a single reduction
+  // is needed in parallel.
+  std::vector<double> local_values(n_vectors*n_probes*n_components, 0.0);
+
+  for (unsigned int i=0; i<n_probes; ++i)
+    if (owned[i])
+      {
+        const std::vector<types::global_dof_index> &indices = dof_indices[i];
+        const FullMatrix<double> &shapes = shape_values[i];
+        for (unsigned int v=0; v<n_vectors; ++v)
+          {
+            const VEC &vec = *vectors[v];
+            double *val = &local_values[(v*n_probes+i)*n_components];
+            for (unsigned int j=0; j<indices.size(); ++j)
+              {
+                const double coefficient = vec(indices[j]);
+                if (coefficient != 0)
+                  for (unsigned int c=0; c<n_components; ++c)
+                    val[c] += coefficient*shapes(j,c);
+              }
+          }
+      }
+
+  std::vector<double> global_values(local_values.size());
+  Utilities::MPI::sum(local_values, comm, global_values);
+
+  values.resize(n_vectors);
+  for (unsigned int v=0; v<n_vectors; ++v)
+    {
+      values[v].resize(n_probes, Vector<double>(n_components));
+      for (unsigned int i=0; i<n_probes; ++i)
+        {
+          values[v][i].reinit(n_components);
+          for (unsigned int c=0; c<n_components; ++c)
+            values[v][i][c] = global_values[(v*n_probes+i)*n_components+c];
+        }
+    }
+}
+
+
+
+template <int dim, int spacedim>
+template<typename VEC>
+void ParsedPointProbe<dim,spacedim>::evaluate(const VEC &vector,
+                                              std::vector<Vector<double> > &values)
+{
+  std::vector<const VEC *> vectors(1, &vector);
+  std::vector<std::vector<Vector<double> > > all_values;
+  evaluate(vectors, all_values);
+  values.swap(all_values[0]);
+}
+
+D2K_NAMESPACE_CLOSE
+
+#endif
@@ -118,6 +118,19 @@ public:
    */
   LinearOperator<VECTOR> prec;
 
+  /**
+   * Set the reduction of the residual required by the following
+   * solves, e.g., to the forcing term of an inexact Newton method.
+   * The reduction read from the parameter file is restored by
+   * reset_reduction().
+   */
+  void set_reduction(const double reduction);
+
+  /**
+   * Restore the reduction read from the parameter file.
+   */
+  void reset_reduction();
+
   /**
    * ReductionControl. Used internally by the solver.
    */
@@ -142,7 +155,8 @@ private:
 
   /**
    * Default reduction required to succesfully complete a solution
-   * step.
+   * step. It is overwritten by the value read from the parameter
+   * file.
    */
   double reduction;
 
@@ -192,6 +206,21 @@ void ParsedSolver<VECTOR>::parse_parameters(ParameterHandler &prm)
 {
   ParameterAcceptor::parse_parameters(prm);
   control.parse_parameters(prm);
+  reduction = control.reduction();
+}
+
+
+template<typename VECTOR>
+void ParsedSolver<VECTOR>::set_reduction(const double new_reduction)
+{
+  control.set_reduction(new_reduction);
+}
+
+
+template<typename VECTOR>
+void ParsedSolver<VECTOR>::reset_reduction()
+{
+  control.set_reduction(reduction);
 }
 
 
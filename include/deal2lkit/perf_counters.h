@@ -0,0 +1,127 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#ifndef _d2k_perf_counters_h
+#define _d2k_perf_counters_h
+
+#include <deal2lkit/config.h>
+
+#include <array>
+#include <string>
+#include <vector>
+
+D2K_NAMESPACE_OPEN
+
+/**
+ * Hardware performance counters of the calling thread, read through
+ * the Linux perf_event_open() interface.
+ *
+ * The counters are opened by the constructor and count the events of
+ * the thread that created the object, in user space only. Events that
+ * the processor does not support, or that cannot be opened because of
+ * the value of /proc/sys/kernel/perf_event_paranoid, are not available
+ * and read as zero. On other systems no event is available.
+ *
+ * The events are opened in two groups, whose events are always counted
+ * together: cycles, instructions, branches and branch misses in the
+ * first one, and cache references, cache misses and L1 data cache read
+ * misses in the second one. If the two groups do not fit in the
+ * counters of the processor at the same time, the kernel alternates
+ * them, and the values returned by read() are scaled accordingly.
+ *
+ * @code
+ * PerfCounters counters;
+ * auto start = counters.read();
+ * assemble_system();
+ * auto end = counters.read();
+ * double ipc = (end[PerfCounters::instructions] - start[PerfCounters::instructions]) /
+ *              (end[PerfCounters::cycles] - start[PerfCounters::cycles]);
+ * @endcode
+ *
+ * Every call to read() is a system call per group: counters are meant
+ * for sections that last much longer than a microsecond.
+ */
+class PerfCounters
+{
+public:
+  /**
+   * The events that are counted.
+   */
+  enum Event
+  {
+    cycles,
+    instructions,
+    branches,
+    branch_misses,
+    cache_references,
+    cache_misses,
+    l1d_read_misses,
+    n_events
+  };
+
+  /**
+   * Counts of all the events.
+   */
+  typedef std::array<double, n_events> Values;
+
+  /**
+   * Open and start the counters of the calling thread.
+   */
+  PerfCounters();
+
+  /**
+   * Close the counters.
+   */
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  /**
+   * Return true if @p event is counted.
+   */
+  bool is_available(const Event event) const;
+
+  /**
+   * Return a short name of @p event.
+   */
+  static std::string name(const Event event);
+
+  /**
+   * Counts of the events since the construction of this object.
+   */
+  Values read() const;
+
+private:
+  /**
+   * File descriptor of each event, or -1 if it is not available.
+   */
+  std::array<int, n_events> fds;
+
+  /**
+   * Group of each event, and position in the values of the group.
+   */
+  std::array<unsigned int, n_events> group;
+  std::array<unsigned int, n_events> position;
+
+  /**
+   * File descriptor of the first event of each group, or -1.
+   */
+  std::vector<int> leaders;
+};
+
+D2K_NAMESPACE_CLOSE
+
+#endif
@@ -0,0 +1,234 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#ifndef _d2k_profiler_h
+#define _d2k_profiler_h
+
+#include <deal2lkit/config.h>
+#include <deal2lkit/perf_counters.h>
+#include <deal.II/base/mpi.h>
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+D2K_NAMESPACE_OPEN
+
+/**
+ * A lightweight hierarchical profiler.
+ *
+ * Code sections are timed by placing D2K_PROFILE_SCOPE("name") at the
+ * beginning of a block. Each call site registers its name only once,
+ * in a static handle, so entering a scope costs a clock reading and a
+ * lookup among the children of the enclosing scope, without any
+ * string comparison nor lock.
+ *
+ * @code
+ * void assemble()
+ * {
+ *   D2K_PROFILE_SCOPE("assemble");
+ *   for (auto cell : cells)
+ *     {
+ *       D2K_PROFILE_SCOPE("cell");
+ *       ...
+ *     }
+ * }
+ * ...
+ * Profiler::enable();
+ * assemble();
+ * Profiler::print_summary(std::cout, MPI_COMM_WORLD);
+ * @endcode
+ *
+ * Every thread records its scopes in its own buffer: a tree of the
+ * nested scopes with their number of calls and total time and,
+ * optionally, the list of the timed intervals for a trace. The results
+ * are gathered by the export functions, which are collective on the
+ * given communicator, and must be called when no other thread is
+ * inside a scope.
+ *
+ * Hardware counters (see PerfCounters) can be recorded as well, together
+ * with the floating point operations declared by add_flops(), and
+ * reported by print_hardware_summary(). Reading the counters costs a
+ * few system calls per scope, which is negligible only for scopes
+ * longer than some microseconds.
+ *
+ * The sections of the library that are called most often (the
+ * callbacks of the \sundials integrators, FEValuesCache::reinit(),
+ * ParsedDataOut::write_data_and_clear()) are instrumented when
+ * deal2lkit is configured with D2K_WITH_PROFILING=ON.
+ */
+namespace Profiler
+{
+  /**
+   * Handle of a call site, created once per site by D2K_PROFILE_SCOPE.
+   */
+  class Site
+  {
+  public:
+    /**
+     * Register @p name. Sites with the same name are merged.
+     */
+    Site(const std::string &name);
+
+    /** Index of the name. */
+    const unsigned int id;
+  };
+
+  /**
+   * Time the lifetime of this object as a nested scope of the current
+   * thread. It does nothing if the profiler is not enabled.
+   */
+  class Scope
+  {
+  public:
+    Scope(const Site &site);
+
+    ~Scope();
+
+  private:
+    /** Node of the tree of the thread, or invalid if not enabled. */
+    unsigned int node;
+
+    /** Start time, in nanoseconds. */
+    std::int64_t start;
+
+    /** True if the hardware counters were read at the start. */
+    bool counted;
+  };
+
+  /**
+   * Start profiling. If @p record_trace is true, every interval is
+   * stored for write_chrome_trace(), up to @p max_trace_events per
+   * thread. If @p hardware_counters is true, the hardware counters of
+   * each thread and the floating point operations are recorded too.
+   */
+  void enable(const bool record_trace=false,
+              const unsigned int max_trace_events=1000000,
+              const bool hardware_counters=false);
+
+  /**
+   * Stop profiling. The scopes that are open keep being timed.
+   */
+  void disable();
+
+  /**
+   * Return true if the profiler is enabled.
+   */
+  bool is_enabled();
+
+  /**
+   * Clear all the recorded data. It must be called outside of any
+   * scope.
+   */
+  void reset();
+
+  /**
+   * Number of calls of the scope @p path, made of the names of the
+   * nested scopes separated by ';', summed over the threads of this
+   * process.
+   */
+  unsigned long int n_calls(const std::string &path);
+
+  /**
+   * Total time, in seconds, spent in the scope @p path, summed over
+   * the threads of this process.
+   */
+  double total_time(const std::string &path);
+
+  /**
+   * Add @p n_flops floating point operations to the open scopes of the
+   * calling thread. They are only recorded if the hardware counters are
+   * enabled, and are used to compute the GFLOP/s of each scope, since
+   * the processors do not provide a portable event for them.
+   */
+  void add_flops(const double n_flops);
+
+  /**
+   * Floating point operations declared in the scope @p path, summed
+   * over the threads of this process.
+   */
+  double n_flops(const std::string &path);
+
+  /**
+   * Count of @p event in the scope @p path, summed over the threads of
+   * this process.
+   */
+  double hardware_counter(const std::string &path,
+                          const PerfCounters::Event event);
+
+  /**
+   * Print, on the first process, a table with the number of calls and
+   * the minimum, average and maximum time over the processes of each
+   * scope.
+   */
+  void print_summary(std::ostream &out,
+                     const MPI_Comm comm);
+
+  /**
+   * Print, on the first process, a table with the metrics derived from
+   * the hardware counters of each scope: instructions per cycle, L1 data
+   * cache read misses per thousand instructions, cache and branch miss
+   * rates, and GFLOP/s. Counts are summed over threads and processes,
+   * and the GFLOP/s are relative to the maximum time over the
+   * processes. Metrics whose events are not available on some process
+   * are shown as "-".
+   */
+  void print_hardware_summary(std::ostream &out,
+                              const MPI_Comm comm);
+
+  /**
+   * Write, on the first process, the scopes in the folded format of
+   * flame graph tools, i.e., "outer;inner microseconds", with the self
+   * time summed over all threads and processes.
+   */
+  void write_flame_graph(std::ostream &out,
+                         const MPI_Comm comm);
+
+  /**
+   * Write, on the first process, the intervals recorded by all threads
+   * and processes in the Chrome trace event format, which can be read
+   * by chrome://tracing or Perfetto. Processes are identified by their
+   * rank, and threads by the order in which they entered their first
+   * scope.
+   */
+  void write_chrome_trace(std::ostream &out,
+                          const MPI_Comm comm);
+}
+
+D2K_NAMESPACE_CLOSE
+
+#define D2K_PROFILE_CONCAT_IMPL(a, b) a##b
+#define D2K_PROFILE_CONCAT(a, b) D2K_PROFILE_CONCAT_IMPL(a, b)
+
+/**
+ * Time the enclosing block as a scope called @p name, which must not
+ * contain ';'.
+ */
+#define D2K_PROFILE_SCOPE(name) \
+  static const deal2lkit::Profiler::Site D2K_PROFILE_CONCAT(d2k_profile_site_, __LINE__)(name); \
+  deal2lkit::Profiler::Scope D2K_PROFILE_CONCAT(d2k_profile_scope_, __LINE__)(D2K_PROFILE_CONCAT(d2k_profile_site_, __LINE__))
+
+/**
+ * Scopes of the library itself, which cost nothing unless deal2lkit is
+ * configured with D2K_WITH_PROFILING=ON.
+ */
+#ifdef D2K_WITH_PROFILING
+#define D2K_INTERNAL_PROFILE_SCOPE(name) D2K_PROFILE_SCOPE(name)
+#else
+#define D2K_INTERNAL_PROFILE_SCOPE(name)
+#endif
+
+#endif
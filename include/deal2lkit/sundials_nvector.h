@@ -0,0 +1,131 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#ifndef _d2k_sundials_nvector_h
+#define _d2k_sundials_nvector_h
+
+#include <deal2lkit/config.h>
+
+#ifdef D2K_WITH_SUNDIALS
+
+#include <deal2lkit/utilities.h>
+#include <deal.II/base/index_set.h>
+#include <deal.II/base/mpi.h>
+
+#include <sundials/sundials_nvector.h>
+
+using namespace dealii;
+
+D2K_NAMESPACE_OPEN
+
+/**
+ * A SUNDIALS N_Vector implementation whose content is a deal.II
+ * vector.
+ *
+ * The functions in this namespace create N_Vector objects that either
+ * wrap an existing deal.II vector (without owning or copying it), or
+ * own a new deal.II vector with the same layout of a given one. All
+ * N_Vector operations required by IDA and KINSOL are mapped onto the
+ * methods of the underlying vector (sadd(), equ(), scale(), norms and
+ * scalar products), or onto loops over the arrays of its locally owned
+ * elements, followed by a single MPI reduction for the norms and the
+ * tests. No operation calls compress().
+ *
+ * Clones created by SUNDIALS from one of these vectors are of the same
+ * kind, so that all the internal work vectors of the solvers are
+ * deal.II vectors too, and the user callbacks can receive references
+ * to them, without allocations and copies.
+ *
+ * All the resulting N_Vector objects are destroyed with the usual
+ * N_VDestroy() function. When a wrapping vector is destroyed, the
+ * wrapped deal.II vector is left untouched.
+ *
+ * The supported vector types are BlockVector<double>, and, if deal.II
+ * was configured with MPI, TrilinosWrappers::MPI::Vector,
+ * TrilinosWrappers::MPI::BlockVector, PETScWrappers::MPI::Vector and
+ * PETScWrappers::MPI::BlockVector.
+ */
+namespace NVectorWrappers
+{
+  /**
+   * The content of the N_Vector objects created in this namespace.
+   */
+  template<typename VEC>
+  struct Content
+  {
+    /**
+     * The deal.II vector.
+     */
+    VEC *vector;
+
+    /**
+     * Whether the N_Vector owns the deal.II vector.
+     */
+    bool owns_vector;
+
+    /**
+     * The elements of the vector that are owned by this process.
+     */
+    IndexSet locally_owned;
+
+    /**
+     * Communicator used for the reductions.
+     */
+    MPI_Comm comm;
+  };
+
+  /**
+   * Create an N_Vector that wraps the given vector. The N_Vector does
+   * not own @p vector, which must live longer than the returned object.
+   */
+  template<typename VEC>
+  N_Vector create_view(VEC &vector,
+                       const MPI_Comm comm=MPI_COMM_WORLD);
+
+  /**
+   * Create an N_Vector that owns a new deal.II vector with the same
+   * layout and content of the given one.
+   */
+  template<typename VEC>
+  N_Vector create_copy(const VEC &vector,
+                       const MPI_Comm comm=MPI_COMM_WORLD);
+
+  /**
+   * Update an N_Vector created by one of the functions above after the
+   * layout of @p vector has changed, e.g., after mesh refinement. A
+   * view is redirected to @p vector, while a copy resizes its own
+   * deal.II vector in place and copies the content of @p vector.
+   */
+  template<typename VEC>
+  void reinit(N_Vector v, const VEC &vector);
+
+  /**
+   * Return the deal.II vector stored in an N_Vector created by one of
+   * the functions above, or cloned from one of them.
+   */
+  template<typename VEC>
+  inline VEC &get(N_Vector v)
+  {
+    Assert(v != nullptr, ExcNotInitialized());
+    Assert(v->content != nullptr, ExcNotInitialized());
+    return *static_cast<Content<VEC> *>(v->content)->vector;
+  }
+}
+
+D2K_NAMESPACE_CLOSE
+
+#endif
+
+#endif
@@ -0,0 +1,239 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#ifndef _d2k_sundials_statistics_h
+#define _d2k_sundials_statistics_h
+
+#include <deal2lkit/config.h>
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+D2K_NAMESPACE_OPEN
+
+/**
+ * Number of calls and accumulated wall time of a user callback.
+ */
+struct CallbackStatistics
+{
+  CallbackStatistics();
+
+  /** Number of calls. */
+  unsigned long int n_calls;
+
+  /** Total wall time spent in the callback, in seconds. */
+  double wall_time;
+
+  CallbackStatistics operator-(const CallbackStatistics &other) const;
+  CallbackStatistics operator+(const CallbackStatistics &other) const;
+};
+
+
+/**
+ * Time the execution of a callback for the lifetime of this object,
+ * and add it to the given CallbackStatistics.
+ *
+ * @code
+ * {
+ *   CallbackScope scope(statistics.residual);
+ *   err = solver.residual(y, res);
+ * }
+ * @endcode
+ */
+class CallbackScope
+{
+public:
+  CallbackScope(CallbackStatistics &stats);
+
+  ~CallbackScope();
+
+private:
+  CallbackStatistics &stats;
+  const std::chrono::steady_clock::time_point start;
+};
+
+
+/**
+ * Base class for the statistics of the \sundials solvers. Derived
+ * classes list their entries in get_entries(), and this class knows
+ * how to print them as a table or as a JSON object.
+ */
+class SolverStatistics
+{
+public:
+  virtual ~SolverStatistics();
+
+  /**
+   * Fill @p entries with (name, value) pairs, in the order they should
+   * be printed.
+   */
+  virtual void get_entries(std::vector<std::pair<std::string, double> > &entries) const = 0;
+
+  /**
+   * Print the statistics as a two columns table, with an optional
+   * title.
+   */
+  void print_table(std::ostream &out,
+                   const std::string &title="") const;
+
+  /**
+   * Print the statistics as a single JSON object.
+   */
+  void print_json(std::ostream &out) const;
+
+  /**
+   * Print the statistics in the given @p format, which is either
+   * "table" or "json". Nothing is printed if @p format is "none".
+   */
+  void print(std::ostream &out,
+             const std::string &format,
+             const std::string &title="") const;
+
+protected:
+  /**
+   * Append the entries of a callback, as name_calls and name_wall_time.
+   */
+  static void add_entries(std::vector<std::pair<std::string, double> > &entries,
+                          const std::string &name,
+                          const CallbackStatistics &stats);
+};
+
+
+/**
+ * Statistics of IDAInterface. Counters are accumulated over all the
+ * restarts of a single call to IDAInterface::solve_dae().
+ */
+struct IDAStatistics : public SolverStatistics
+{
+  IDAStatistics();
+
+  /** Number of time steps (IDAGetNumSteps). */
+  long int n_steps;
+
+  /** Number of residual evaluations (IDAGetNumResEvals). */
+  long int n_residual_evaluations;
+
+  /** Number of Jacobian setups (IDAGetNumLinSolvSetups). */
+  long int n_jacobian_setups;
+
+  /** Number of nonlinear iterations (IDAGetNumNonlinSolvIters). */
+  long int n_nonlinear_iterations;
+
+  /** Number of nonlinear convergence failures (IDAGetNumNonlinSolvConvFails). */
+  long int n_nonlinear_convergence_failures;
+
+  /** Number of local error test failures (IDAGetNumErrTestFails). */
+  long int n_error_test_failures;
+
+  /** Number of Krylov iterations (IDASpilsGetNumLinIters). */
+  long int n_linear_iterations;
+
+  /** Number of restarts, i.e., calls to IDAInterface::reset_dae(). */
+  long int n_restarts;
+
+  /** Number of events located by root finding. */
+  long int n_events;
+
+  /** Order used in the last step (IDAGetLastOrder). */
+  int last_order;
+
+  /** Size of the last step (IDAGetLastStep). */
+  double last_step_size;
+
+  /** Size of the step being attempted (IDAGetCurrentStep). */
+  double current_step_size;
+
+  /** Time reached by the solver (IDAGetCurrentTime). */
+  double current_time;
+
+  /** User callbacks. */
+  CallbackStatistics residual;
+  CallbackStatistics setup_jacobian;
+  CallbackStatistics solve_jacobian_system;
+  CallbackStatistics jacobian_vmult;
+  CallbackStatistics setup_preconditioner;
+  CallbackStatistics solve_preconditioner;
+  CallbackStatistics event_function;
+  CallbackStatistics output_step;
+
+  /**
+   * Difference of the counters, e.g., to obtain the statistics of a
+   * single output interval. Non cumulative quantities (last order,
+   * step sizes, current time) are taken from this object.
+   */
+  IDAStatistics operator-(const IDAStatistics &previous) const;
+
+  virtual void get_entries(std::vector<std::pair<std::string, double> > &entries) const;
+};
+
+
+/**
+ * Statistics of KINSOLInterface, relative to the last call to
+ * KINSOLInterface::solve().
+ */
+struct KINSOLStatistics : public SolverStatistics
+{
+  KINSOLStatistics();
+
+  /** Number of nonlinear iterations (KINGetNumNonlinSolvIters). */
+  long int n_nonlinear_iterations;
+
+  /** Number of residual evaluations (KINGetNumFuncEvals). */
+  long int n_residual_evaluations;
+
+  /** Number of beta condition failures (KINGetNumBetaCondFails). */
+  long int n_beta_condition_failures;
+
+  /** Number of backtrack operations (KINGetNumBacktrackOps). */
+  long int n_backtrack_operations;
+
+  /** Number of Krylov iterations (KINSpilsGetNumLinIters). */
+  long int n_linear_iterations;
+
+  /** Scaled norm of the final residual (KINGetFuncNorm). */
+  double residual_norm;
+
+  /** Scaled length of the last step (KINGetStepLength). */
+  double step_length;
+
+  /** User callbacks. */
+  CallbackStatistics residual;
+  CallbackStatistics setup_jacobian;
+  CallbackStatistics solve_linear_system;
+  CallbackStatistics jacobian_vmult;
+  CallbackStatistics setup_preconditioner;
+  CallbackStatistics solve_preconditioner;
+
+  /**
+   * Sum of the counters, e.g., to accumulate the statistics of many
+   * solves. Non cumulative quantities are taken from @p other.
+   */
+  KINSOLStatistics operator+(const KINSOLStatistics &other) const;
+
+  /**
+   * Difference of the counters. Non cumulative quantities are taken
+   * from this object.
+   */
+  KINSOLStatistics operator-(const KINSOLStatistics &previous) const;
+
+  virtual void get_entries(std::vector<std::pair<std::string, double> > &entries) const;
+};
+
+D2K_NAMESPACE_CLOSE
+
+#endif
@@ -29,6 +29,7 @@
 #include <sstream>
 #include <sys/ioctl.h>    // to know the number of cols and rows of a shell
 #include <chrono>         // for TimeUtilities std::chrono
+#include <functional>     // for TimeUtilities::benchmark
 #include <stdio.h>
 
 #include <deal.II/lac/block_vector.h>
@@ -71,6 +72,20 @@ std::string demangle(const char *name);
  *
  *  All measures are stored in seconds.
  *  Usage: get_start_time() should be used before get_end_time() and viceversa.
+ *
+ * It is also a micro-benchmark harness: benchmark() runs a function a
+ * few times to warm it up, and then measures it until the confidence
+ * interval of the mean time is small enough. The statistics of the
+ * measures can be queried, or written in CSV or JSON format.
+ *
+ * @code
+ * TimeUtilities timer;
+ * timer.benchmark([&] ()
+ * {
+ *   matrix.vmult(dst, src);
+ * });
+ * timer.write_csv(std::cout, "vmult");
+ * @endcode
  */
 class TimeUtilities
 {
@@ -102,6 +117,88 @@ public:
    */
   int get_num_measures();
 
+  /**
+   * It removes all the measures.
+   */
+  void clear();
+
+  /**
+   * Measure @p function. It is first run @p n_warmup_runs times without
+   * measuring it, and then measured at least @p min_runs and at most
+   * @p max_runs times, stopping as soon as the half width of the 95%
+   * confidence interval of the mean is smaller than
+   * @p relative_confidence times the mean, or the measures took more
+   * than @p max_time seconds.
+   *
+   * If @p cache_flush_size is not zero, a buffer of that many bytes,
+   * which should be larger than the last level cache, is written
+   * before each run, so that every run starts with a cold cache.
+   *
+   * The measures are added to the ones already stored. It returns the
+   * number of measures done by this call.
+   */
+  unsigned int benchmark(const std::function<void()> &function,
+                         const unsigned int n_warmup_runs=1,
+                         const double relative_confidence=0.01,
+                         const unsigned int min_runs=5,
+                         const unsigned int max_runs=1000,
+                         const double max_time=10.0,
+                         const std::size_t cache_flush_size=0);
+
+  /**
+   * Minimum of the measures.
+   */
+  double get_min() const;
+
+  /**
+   * Maximum of the measures.
+   */
+  double get_max() const;
+
+  /**
+   * Mean of the measures.
+   */
+  double get_mean() const;
+
+  /**
+   * Median of the measures.
+   */
+  double get_median() const;
+
+  /**
+   * The @p p-th percentile of the measures, with 0 <= @p p <= 100,
+   * linearly interpolated between the closest ones.
+   */
+  double get_percentile(const double p) const;
+
+  /**
+   * Sample standard deviation of the measures.
+   */
+  double get_standard_deviation() const;
+
+  /**
+   * Half width of the 95% confidence interval of the mean, using the
+   * Student's t distribution.
+   */
+  double get_confidence_interval() const;
+
+  /**
+   * Write a line with @p name and the number of measures, minimum,
+   * median, 95th percentile, maximum, mean and standard deviation,
+   * separated by commas. The names of the columns are written first if
+   * @p header is true.
+   */
+  void write_csv(std::ostream &out,
+                 const std::string &name,
+                 const bool header=true) const;
+
+  /**
+   * Write a JSON object with @p name, the statistics of write_csv() and
+   * all the measures.
+   */
+  void write_json(std::ostream &out,
+                  const std::string &name) const;
+
   /**
    * An overload of the operator [] is provided to access to all measures.
    */
@@ -162,12 +259,15 @@ bool create_directory(const std::string &name);
 
 /**
  * A function to copy a list of @p file ( "file1 file2 file3" ) in the
- * destination folder (@p destination)
+ * destination folder (@p destination). Files whose copy has the same
+ * size and is newer than the original are not copied again.
  */
 bool copy_files(const std::string &files, const std::string &destination);
 
 /**
- * A function to make a copy of @p file with the name @p destination
+ * A function to make a copy of @p file with the name @p destination,
+ * or in the directory @p destination. Nothing is done if the copy has
+ * the same size and is newer than @p file.
  */
 bool copy_file(const std::string &files, const std::string &destination);
 
@@ -0,0 +1,139 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#ifndef _d2k_vector_pool_h
+#define _d2k_vector_pool_h
+
+#include <deal2lkit/config.h>
+#include <deal2lkit/utilities.h>
+#include <deal.II/base/mpi.h>
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+using namespace dealii;
+
+D2K_NAMESPACE_OPEN
+
+/**
+ * A pool of vectors, shared by all the classes working with vectors
+ * of type VEC (IMEXStepper, KINSOLInterface and IDAInterface).
+ *
+ * Similar to GrowingVectorMemory, vectors that are no longer used are
+ * kept and handed out again, instead of being deallocated. Vectors
+ * are matched by their size, their locally owned elements, their MPI
+ * communicator and, for block vectors, the sizes of the blocks, so
+ * that vectors of different problems can live in the same pool.
+ * Vectors with ghost elements are never handed out again: their ghost
+ * elements cannot be compared, and they are deallocated as soon as
+ * they are no longer used.
+ *
+ * Vectors are obtained with get(), which returns a shared_ptr that
+ * gives the vector back to the pool when it is destroyed. New vectors
+ * are created with the create_new_vector function of the caller.
+ *
+ * Since the pool is a static object, the unused vectors are
+ * deallocated when MPI is finalized, before the destruction of the
+ * pool: from then on, vectors that are no longer used are deallocated
+ * immediately.
+ *
+ * @code
+ * shared_ptr<VEC> tmp = VectorPool<VEC>::get_pool().get(solution,
+ *                                                       create_new_vector);
+ * @endcode
+ */
+template<typename VEC>
+class VectorPool
+{
+public:
+  /**
+   * Return the pool shared by all the users of VEC.
+   */
+  static VectorPool<VEC> &get_pool();
+
+  /**
+   * Return a vector with the same layout of @p model, set to zero.
+   * If there is no such unused vector in the pool, a new one is
+   * created with @p create_new_vector.
+   */
+  shared_ptr<VEC> get(const VEC &model,
+                      const std::function<shared_ptr<VEC>()> &create_new_vector);
+
+  /**
+   * Deallocate the vectors that are not in use, e.g., after a change
+   * of the mesh made them useless.
+   */
+  void release_unused();
+
+  /**
+   * Number of vectors created by the pool so far.
+   */
+  unsigned int n_allocations() const;
+
+  /**
+   * Number of vectors that are not in use.
+   */
+  unsigned int n_unused() const;
+
+  /**
+   * Memory used by the vectors created by the pool, both the ones in
+   * use and the unused ones, as reported when they were created.
+   */
+  std::size_t memory_consumption() const;
+
+private:
+  /**
+   * State of the pool. It is kept alive by the vectors in use, which
+   * need it to come back.
+   */
+  struct Data
+  {
+    Data();
+
+    /**
+     * Deallocate the unused vectors. The mutex must be locked.
+     */
+    void release_unused();
+
+    mutable std::mutex mutex;
+    std::vector<shared_ptr<VEC> > unused;
+    unsigned int n_allocations;
+    std::size_t memory;
+
+    /**
+     * Whether release_at_finalize() has been registered with MPI, and
+     * whether it has been called.
+     */
+    bool finalize_hook;
+    bool finalized;
+  };
+
+  VectorPool();
+
+  /**
+   * Release the unused vectors of the Data pointed by @p attribute and
+   * stop keeping the vectors that are given back. It is the delete
+   * function of an attribute of MPI_COMM_SELF, which MPI_Finalize()
+   * destroys first.
+   */
+  static int release_at_finalize(MPI_Comm, int, void *attribute, void *);
+
+  shared_ptr<Data> data;
+};
+
+D2K_NAMESPACE_CLOSE
+
+#endif
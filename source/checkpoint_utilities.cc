@@ -0,0 +1,136 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#include <deal2lkit/checkpoint_utilities.h>
+
+#include <deal.II/base/utilities.h>
+
+#include <cstdio>
+#include <fstream>
+
+D2K_NAMESPACE_OPEN
+
+namespace CheckpointUtilities
+{
+  std::string get_file_name(const std::string &prefix,
+                            const MPI_Comm comm,
+                            const bool temporary)
+  {
+    const unsigned int rank = Utilities::MPI::this_mpi_process(comm);
+    return prefix + "-" + Utilities::int_to_string(rank, 4) + ".chk"
+           + (temporary ? ".tmp" : "");
+  }
+
+
+
+  bool exists(const std::string &prefix,
+              const MPI_Comm comm)
+  {
+    std::ifstream in(get_file_name(prefix, comm).c_str());
+    const unsigned int found = in.good() ? 1 : 0;
+    return (Utilities::MPI::min(found, comm) == 1);
+  }
+
+
+
+  void write_header(std::ostream &out,
+                    const std::string &tag,
+                    const unsigned int version,
+                    const unsigned long int id,
+                    const MPI_Comm comm)
+  {
+    write_value(out, (unsigned int)tag.size());
+    out.write(tag.c_str(), tag.size());
+    write_value(out, version);
+    write_value(out, Utilities::MPI::n_mpi_processes(comm));
+    write_value(out, id);
+  }
+
+
+
+  unsigned long int read_header(std::istream &in,
+                                const std::string &tag,
+                                const unsigned int version,
+                                const MPI_Comm comm)
+  {
+    unsigned int size;
+    read_value(in, size);
+    std::string file_tag(size, ' ');
+    if (size > 0)
+      in.read(&file_tag[0], size);
+    AssertThrow(in && file_tag == tag,
+                ExcMessage("This checkpoint was not written by " + tag + "."));
+
+    unsigned int file_version;
+    read_value(in, file_version);
+    AssertThrow(file_version == version,
+                ExcMessage("This checkpoint was written with version "
+                           + Utilities::int_to_string(file_version)
+                           + " of the format of " + tag + ", instead of version "
+                           + Utilities::int_to_string(version) + "."));
+
+    unsigned int n_procs;
+    read_value(in, n_procs);
+    AssertThrow(n_procs == Utilities::MPI::n_mpi_processes(comm),
+                ExcMessage("This checkpoint was written with "
+                           + Utilities::int_to_string(n_procs)
+                           + " processes. Restart with the same number of processes."));
+
+    unsigned long int id;
+    read_value(in, id);
+    AssertThrow(Utilities::MPI::min(id, comm) == Utilities::MPI::max(id, comm),
+                ExcMessage("The checkpoint files of the processes belong to "
+                           "different checkpoints: the run that wrote them "
+                           "was interrupted while saving a checkpoint."));
+    return id;
+  }
+
+
+
+  void commit(const std::string &prefix,
+              const MPI_Comm comm)
+  {
+#ifdef DEAL_II_WITH_MPI
+    MPI_Barrier(comm);
+#endif
+    const std::string tmp = get_file_name(prefix, comm, true);
+    const std::string final_name = get_file_name(prefix, comm);
+    const int status = std::rename(tmp.c_str(), final_name.c_str());
+    AssertThrow(status == 0,
+                ExcMessage("Could not rename " + tmp + " to " + final_name + "."));
+  }
+
+
+
+  bool interval_elapsed(std::chrono::steady_clock::time_point &last,
+                        const double interval,
+                        const MPI_Comm comm)
+  {
+    if (interval <= 0)
+      return false;
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> elapsed = now - last;
+
+    // All processes have to agree
+    if (Utilities::MPI::max(elapsed.count(), comm) < interval)
+      return false;
+
+    last = now;
+    return true;
+  }
+}
+
+D2K_NAMESPACE_CLOSE
@@ -19,6 +19,7 @@
 #include <deal.II/base/quadrature_lib.h>
 #include <deal.II/base/utilities.h>
 #include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/memory_consumption.h>
 
 #include <deal.II/grid/grid_tools.h>
 
@@ -263,6 +264,19 @@ void ErrorHandler<ntables>::output_table (ConditionalOStream &pcout, const unsig
   if ( pcout.is_active() ) output_table (pcout.get_stream(), table_no);
 }
 
+template <int ntables>
+std::size_t ErrorHandler<ntables>::memory_consumption () const
+{
+  std::size_t bytes = (sizeof(*this) +
+                       MemoryConsumption::memory_consumption(headers) +
+                       MemoryConsumption::memory_consumption(latex_headers) +
+                       MemoryConsumption::memory_consumption(latex_captions) +
+                       MemoryConsumption::memory_consumption(names) +
+                       MemoryConsumption::memory_consumption(rate_keys) +
+                       tables.capacity()*sizeof(ConvergenceTable));
+  return bytes;
+}
+
 D2K_NAMESPACE_CLOSE
 
 
@@ -15,7 +15,11 @@
 
 
 #include <deal2lkit/ida_interface.h>
+#include <deal2lkit/checkpoint_utilities.h>
+#include <deal2lkit/sundials_nvector.h>
 #include <deal2lkit/utilities.h>
+#include <deal2lkit/vector_pool.h>
+#include <deal2lkit/profiler.h>
 
 #ifdef D2K_WITH_SUNDIALS
 
@@ -33,6 +37,7 @@
 #endif
 #include <deal.II/base/utilities.h>
 
+#include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <ida/ida_impl.h>
@@ -43,8 +48,22 @@ using namespace dealii;
 
 D2K_NAMESPACE_OPEN
 
+namespace internal
+{
+  template<typename VEC>
+  IDAStatistics &callback_statistics(IDAInterface<VEC> &solver)
+  {
+    return solver.statistics;
+  }
+}
+
 namespace
 {
+  /**
+   * Version of the format of the checkpoint files.
+   */
+  const unsigned int checkpoint_version = 1;
+
 
 
   template<typename VEC>
@@ -52,17 +71,33 @@ namespace
                      N_Vector rr, void *user_data)
   {
     IDAInterface<VEC> &solver = *static_cast<IDAInterface<VEC> *>(user_data);
+    CallbackScope scope(internal::callback_statistics(solver).residual);
+    D2K_INTERNAL_PROFILE_SCOPE("IDA residual");
 
-    shared_ptr<VEC> src_yy = solver.create_new_vector();
-    shared_ptr<VEC> src_yp = solver.create_new_vector();
-    shared_ptr<VEC> residual = solver.create_new_vector();
+    int err = solver.residual(tt,
+                              NVectorWrappers::get<VEC>(yy),
+                              NVectorWrappers::get<VEC>(yp),
+                              NVectorWrappers::get<VEC>(rr));
 
-    copy(*src_yy, yy);
-    copy(*src_yp, yp);
+    return err;
+  }
 
-    int err = solver.residual(tt, *src_yy, *src_yp, *residual);
 
-    copy(rr, *residual);
+
+  template<typename VEC>
+  int t_dae_events(realtype tt, N_Vector yy, N_Vector yp,
+                   realtype *gout, void *user_data)
+  {
+    IDAInterface<VEC> &solver = *static_cast<IDAInterface<VEC> *>(user_data);
+    CallbackScope scope(internal::callback_statistics(solver).event_function);
+    D2K_INTERNAL_PROFILE_SCOPE("IDA event function");
+
+    std::vector<double> values(solver.get_n_events());
+    int err = solver.event_function(tt,
+                                    NVectorWrappers::get<VEC>(yy),
+                                    NVectorWrappers::get<VEC>(yp),
+                                    values);
+    std::copy(values.begin(), values.end(), gout);
 
     return err;
   }
@@ -83,16 +118,12 @@ namespace
     (void) tmp3;
     (void) resp;
     IDAInterface<VEC> &solver = *static_cast<IDAInterface<VEC> *>(IDA_mem->ida_user_data);
-
-    shared_ptr<VEC> src_yy = solver.create_new_vector();
-    shared_ptr<VEC> src_yp = solver.create_new_vector();
-
-    copy(*src_yy, yy);
-    copy(*src_yp, yp);
+    CallbackScope scope(internal::callback_statistics(solver).setup_jacobian);
+    D2K_INTERNAL_PROFILE_SCOPE("IDA setup jacobian");
 
     int err = solver.setup_jacobian(IDA_mem->ida_tn,
-                                    *src_yy,
-                                    *src_yp,
+                                    NVectorWrappers::get<VEC>(yy),
+                                    NVectorWrappers::get<VEC>(yp),
                                     IDA_mem->ida_cj);
     return err;
   }
@@ -111,15 +142,105 @@ namespace
     (void) yp;
     (void) resp;
     IDAInterface<VEC> &solver = *static_cast<IDAInterface<VEC> *>(IDA_mem->ida_user_data);
+    CallbackScope scope(internal::callback_statistics(solver).solve_jacobian_system);
+    D2K_INTERNAL_PROFILE_SCOPE("IDA solve jacobian system");
 
-    shared_ptr<VEC> dst = solver.create_new_vector();
-    shared_ptr<VEC> src = solver.create_new_vector();
+    VEC &src = NVectorWrappers::get<VEC>(b);
+    VEC &dst = solver.get_linear_solver_work_vector();
 
-    copy(*src, b);
+    int err = solver.solve_jacobian_system(src, dst);
 
-    int err = solver.solve_jacobian_system(*src,
-                                           *dst);
-    copy(b, *dst);
+    // The solution has to be returned in b: swap the storage instead
+    // of copying it.
+    src.swap(dst);
+    return err;
+  }
+
+
+
+  template<typename VEC>
+  int t_dae_jtimes(realtype tt,
+                   N_Vector yy,
+                   N_Vector yp,
+                   N_Vector rr,
+                   N_Vector v,
+                   N_Vector Jv,
+                   realtype c_j,
+                   void *user_data,
+                   N_Vector tmp1,
+                   N_Vector tmp2)
+  {
+    (void) rr;
+    (void) tmp1;
+    (void) tmp2;
+    IDAInterface<VEC> &solver = *static_cast<IDAInterface<VEC> *>(user_data);
+    CallbackScope scope(internal::callback_statistics(solver).jacobian_vmult);
+    D2K_INTERNAL_PROFILE_SCOPE("IDA jacobian vmult");
+
+    int err = solver.jacobian_vmult(tt,
+                                    NVectorWrappers::get<VEC>(yy),
+                                    NVectorWrappers::get<VEC>(yp),
+                                    c_j,
+                                    NVectorWrappers::get<VEC>(v),
+                                    NVectorWrappers::get<VEC>(Jv));
+    return err;
+  }
+
+
+
+  template<typename VEC>
+  int t_dae_prec_setup(realtype tt,
+                       N_Vector yy,
+                       N_Vector yp,
+                       N_Vector rr,
+                       realtype c_j,
+                       void *user_data,
+                       N_Vector tmp1,
+                       N_Vector tmp2,
+                       N_Vector tmp3)
+  {
+    (void) rr;
+    (void) tmp1;
+    (void) tmp2;
+    (void) tmp3;
+    IDAInterface<VEC> &solver = *static_cast<IDAInterface<VEC> *>(user_data);
+    CallbackScope scope(internal::callback_statistics(solver).setup_preconditioner);
+    D2K_INTERNAL_PROFILE_SCOPE("IDA setup preconditioner");
+
+    int err = solver.setup_preconditioner(tt,
+                                          NVectorWrappers::get<VEC>(yy),
+                                          NVectorWrappers::get<VEC>(yp),
+                                          c_j);
+    return err;
+  }
+
+
+
+  template<typename VEC>
+  int t_dae_prec_solve(realtype tt,
+                       N_Vector yy,
+                       N_Vector yp,
+                       N_Vector rr,
+                       N_Vector rvec,
+                       N_Vector zvec,
+                       realtype c_j,
+                       realtype delta,
+                       void *user_data,
+                       N_Vector tmp)
+  {
+    (void) rr;
+    (void) delta;
+    (void) tmp;
+    IDAInterface<VEC> &solver = *static_cast<IDAInterface<VEC> *>(user_data);
+    CallbackScope scope(internal::callback_statistics(solver).solve_preconditioner);
+    D2K_INTERNAL_PROFILE_SCOPE("IDA solve preconditioner");
+
+    int err = solver.solve_preconditioner(tt,
+                                          NVectorWrappers::get<VEC>(yy),
+                                          NVectorWrappers::get<VEC>(yp),
+                                          c_j,
+                                          NVectorWrappers::get<VEC>(rvec),
+                                          NVectorWrappers::get<VEC>(zvec));
     return err;
   }
 
@@ -131,6 +252,12 @@ IDAInterface<VEC>::IDAInterface(const std::string name,
                                 const MPI_Comm mpi_comm) :
   ParameterAcceptor(name),
   ida_mem(nullptr),
+  yy(nullptr),
+  yp(nullptr),
+  abs_tolls(nullptr),
+  diff_id(nullptr),
+  n_events(0),
+  resuming(false),
   communicator(Utilities::MPI::duplicate_communicator(mpi_comm)),
   pcout(std::cout, Utilities::MPI::this_mpi_process(mpi_comm)==0)
 {
@@ -141,6 +268,12 @@ template <typename VEC>
 IDAInterface<VEC>::IDAInterface(const std::string name) :
   ParameterAcceptor(name),
   ida_mem(nullptr),
+  yy(nullptr),
+  yp(nullptr),
+  abs_tolls(nullptr),
+  diff_id(nullptr),
+  n_events(0),
+  resuming(false),
   pcout(std::cout)
 {
   set_functions_to_trigger_an_assert();
@@ -150,8 +283,7 @@ IDAInterface<VEC>::IDAInterface(const std::string name) :
 template <typename VEC>
 IDAInterface<VEC>::~IDAInterface()
 {
-  if (ida_mem)
-    IDAFree(&ida_mem);
+  free_vectors();
 #ifdef DEAL_II_WITH_MPI
   MPI_Comm_free(&communicator);
 #endif
@@ -232,6 +364,85 @@ void IDAInterface<VEC>::declare_parameters(ParameterHandler &prm)
 
   add_parameter(prm, &verbose,
                 "Show output of time steps", "true", Patterns::Bool());
+
+  add_parameter(prm, &use_dense_output,
+                "Use dense output", "false", Patterns::Bool(),
+                "If true, IDA takes its natural steps (IDA_ONE_STEP), and the "
+                "solution at the output times is interpolated with IDAGetDky. "
+                "Otherwise IDA is forced to stop exactly at each output time.");
+
+  add_parameter(prm, &linear_solver_type,
+                "Linear solver", "custom",
+                Patterns::Selection("custom|spgmr|spbcgs|sptfqmr"),
+                "Linear solver used in the Newton iterations:\n"
+                " custom: setup_jacobian() and solve_jacobian_system() are\n"
+                "    provided by the user\n"
+                " spgmr: matrix-free GMRES of IDA\n"
+                " spbcgs: matrix-free BiCGStab of IDA\n"
+                " sptfqmr: matrix-free TFQMR of IDA\n"
+                "The Krylov solvers use jacobian_vmult() if provided, or a difference "
+                "quotient approximation of the Jacobian times vector product otherwise, "
+                "and the optional setup_preconditioner() and solve_preconditioner().");
+
+  add_parameter(prm, &max_krylov_dimension,
+                "Maximum Krylov subspace dimension", "0",
+                Patterns::Integer(0),
+                "Maximum dimension of the Krylov subspace. 0 means the IDA default (5).");
+
+  add_parameter(prm, &max_gmres_restarts,
+                "Maximum number of GMRES restarts", "5",
+                Patterns::Integer(0));
+
+  add_parameter(prm, &krylov_convergence_factor,
+                "Krylov convergence factor", "0.05",
+                Patterns::Double(0),
+                "Factor between the Krylov and the Newton tolerances.");
+
+  add_parameter(prm, &checkpoint_interval,
+                "Checkpoint interval (wall seconds)", "0",
+                Patterns::Double(),
+                "Save the state of the integrator, including the BDF history, "
+                "when more than this many seconds of wall time have passed since the "
+                "last checkpoint. The check is done after each output. A non positive "
+                "value disables checkpointing.");
+
+  add_parameter(prm, &checkpoint_file,
+                "Checkpoint file prefix", "ida_checkpoint",
+                Patterns::Anything(),
+                "Each process writes the file <prefix>-<rank>.chk");
+
+  add_parameter(prm, &resume_from_checkpoint,
+                "Resume from checkpoint", "false",
+                Patterns::Bool(),
+                "If true and a checkpoint exists, solve_dae() continues from the "
+                "checkpoint, with the same time, step size, order and history. The "
+                "vectors passed to solve_dae() must have the same layout as the ones "
+                "that were saved.");
+
+  add_parameter(prm, &max_pending_outputs,
+                "Maximum number of pending outputs", "0",
+                Patterns::Integer(0),
+                "Output is done by a background thread, which receives copies of the "
+                "solution vectors, while time stepping continues. At most this many "
+                "outputs are queued or running; zero means synchronous output. Pending "
+                "outputs are written before each call to solver_should_restart(), "
+                "which may change anything used by output_step(), e.g., the mesh. "
+                "With MPI, asynchronous output requires MPI_THREAD_MULTIPLE, and "
+                "output is synchronous otherwise.");
+
+  add_parameter(prm, &statistics_format,
+                "Statistics format", "none",
+                Patterns::Selection("none|table|json"),
+                "Print the solver statistics at the end of solve_dae():\n"
+                " none: do not print anything\n"
+                " table: print a human readable table\n"
+                " json: print a single JSON object");
+
+  add_parameter(prm, &print_interval_statistics,
+                "Print statistics of each output interval", "false",
+                Patterns::Bool(),
+                "If true, the statistics of each output interval are printed "
+                "after each output, in the format above.");
 }
 
 
@@ -248,51 +459,49 @@ unsigned int IDAInterface<VEC>::solve_dae(VEC &solution,
 
   int status;
 
-  // The solution is stored in
-  // solution. Here we take only a
-  // view of it.
-
-#ifdef DEAL_II_WITH_MPI
-  IndexSet is = solution.locally_owned_elements();
-  local_system_size = is.n_elements();
+  statistics = IDAStatistics();
+  counters_offset = IDAStatistics();
+  interval_statistics = IDAStatistics();
 
-  yy        = N_VNew_Parallel(communicator,
-                              local_system_size,
-                              system_size);
-
-  yp        = N_VNew_Parallel(communicator,
-                              local_system_size,
-                              system_size);
+  double next_time = initial_time;
 
-  diff_id   = N_VNew_Parallel(communicator,
-                              local_system_size,
-                              system_size);
+  last_checkpoint_time = std::chrono::steady_clock::now();
+  output_queue.set_max_pending(max_pending_outputs);
+  const bool resumed = resume_from_checkpoint &&
+                       load_checkpoint(solution, solution_dot,
+                                       t, next_time, step_number);
 
-  abs_tolls = N_VNew_Parallel(communicator,
-                              local_system_size,
-                              system_size);
+  if (!resumed)
+    {
+      reset_dae(initial_time,
+                solution,
+                solution_dot,
+                initial_step_size,
+                true);
 
-#else
-  yy        = N_VNew_Serial(system_size);
-  yp        = N_VNew_Serial(system_size);
-  diff_id   = N_VNew_Serial(system_size);
-  abs_tolls = N_VNew_Serial(system_size);
-#endif
+      write_output(0, solution, solution_dot, 0);
+    }
 
-  reset_dae(initial_time,
-            solution,
-            solution_dot,
-            initial_step_size,
-            true);
+  IDAStatistics previous_statistics = statistics;
 
-  double next_time = initial_time;
+  // Vectors for the interpolated solution, used with dense output
+  shared_ptr<VEC> dense_y, dense_y_dot;
+  if (use_dense_output)
+    {
+      dense_y = VectorPool<VEC>::get_pool().get(solution, create_new_vector);
+      dense_y_dot = VectorPool<VEC>::get_pool().get(solution, create_new_vector);
+    }
 
-  output_step( 0, solution, solution_dot, 0);
+  // With dense output IDA may reach the final time before all outputs
+  // are written.
+  double output_time = next_time;
 
-  while (t<final_time)
+  while (output_time<final_time)
     {
 
-      next_time += outputs_period;
+      // After an event the same output time is targeted again
+      if (output_time >= next_time)
+        next_time += outputs_period;
       if (verbose)
         {
           pcout << " "//"\r"
@@ -300,19 +509,71 @@ unsigned int IDAInterface<VEC>::solve_dae(VEC &solution,
                 << std::setw(5) << next_time
                 << std::endl;
         }
-      status = IDASolve(ida_mem, next_time, &t, yy, yp, IDA_NORMAL);
+
+      if (use_dense_output)
+        {
+          // Let IDA take its natural steps until the output time is
+          // passed. A single step may cover many output times.
+          status = IDA_SUCCESS;
+          while (t<next_time && t<final_time && status != IDA_ROOT_RETURN)
+            {
+              status = IDASolve(ida_mem, final_time, &t, yy, yp, IDA_ONE_STEP);
+              AssertThrow(status >= 0, ExcMessage("Error in IDA Solver"));
+            }
+        }
+      else
+        status = IDASolve(ida_mem, next_time, &t, yy, yp, IDA_NORMAL);
+
+      // IDA stops at the exact time of an event
+      const bool event_found = (status == IDA_ROOT_RETURN);
+      if (event_found)
+        {
+          ++statistics.n_events;
+          IDAGetRootInfo(ida_mem, &events_found[0]);
+          if (verbose)
+            pcout << "Event found at t = " << t << std::endl;
+        }
 
       status = IDAGetLastStep(ida_mem, &h);
       AssertThrow(status == 0, ExcMessage("Error in IDA Solver"));
 
-      copy(solution, yy);
-      copy(solution_dot, yp);
+      update_statistics();
+
+      // yy and yp are views of solution and solution_dot, which are
+      // already up to date. With dense output they are at time t, and
+      // the solution at the output time is interpolated.
+      output_time = t;
+      VEC *output_y = &solution;
+      VEC *output_y_dot = &solution_dot;
+      if (use_dense_output)
+        {
+          output_time = std::min(next_time, t);
+          interpolate_solution(output_time, *dense_y, *dense_y_dot);
+          output_y = dense_y.get();
+          output_y_dot = dense_y_dot.get();
+        }
+
+      step_number++;
+
+      // With dense output the interpolated solution is written before
+      // checking for a restart, which may change the layout of the
+      // vectors.
+      if (use_dense_output)
+        write_output(output_time, *output_y, *output_y_dot, step_number);
 
-      // Check the solution
-      bool reset = solver_should_restart(t,
-                                         solution,
-                                         solution_dot);
+      // Check the solution. When events are defined, only they can
+      // trigger a restart.
+      bool reset = false;
+      if (n_events == 0 || event_found)
+        {
+          // solver_should_restart() may change what output_step() uses
+          output_queue.wait();
+          reset = solver_should_restart(t,
+                                        solution,
+                                        solution_dot);
+        }
 
+      const bool restarted = reset;
 
       while (reset)
         {
@@ -320,34 +581,53 @@ unsigned int IDAInterface<VEC>::solve_dae(VEC &solution,
           int k = 0;
           IDAGetLastOrder(ida_mem, &k);
           // frac = std::pow((double)k,2.);
+          // An event is located exactly, so there is no need to cut
+          // the step size.
           reset_dae(t, solution, solution_dot,
-                    h/2.0, false);
+                    n_events > 0 ? h : h/2.0, false);
           reset = solver_should_restart(t,
                                         solution,
                                         solution_dot);
         }
 
-      step_number++;
+      if (!use_dense_output)
+        write_output(t, solution, solution_dot,  step_number);
+      else if (restarted)
+        {
+          // IDA has no history before t after a restart, so the next
+          // output time is the first one after t, and the output at t
+          // counts as the last one written.
+          while (next_time <= t)
+            next_time += outputs_period;
+          output_time = t;
+          dense_y = VectorPool<VEC>::get_pool().get(solution, create_new_vector);
+          dense_y_dot = VectorPool<VEC>::get_pool().get(solution, create_new_vector);
+        }
 
-      output_step(t, solution, solution_dot,  step_number);
+      interval_statistics = statistics - previous_statistics;
+      previous_statistics = statistics;
+      if (print_interval_statistics && pcout.is_active())
+        interval_statistics.print(pcout.get_stream(), statistics_format,
+                                  "IDA statistics, output interval ending at t = "
+                                  + Utilities::to_string(output_time));
 
+      if (CheckpointUtilities::interval_elapsed(last_checkpoint_time,
+                                                checkpoint_interval,
+                                                get_communicator()))
+        save_checkpoint(t, next_time, step_number);
 
 
     }
 
+  output_queue.wait();
+
   pcout << std::endl;
+
+  if (pcout.is_active())
+    statistics.print(pcout.get_stream(), statistics_format, "IDA statistics");
+
   // Free the vectors which are no longer used.
-#ifdef DEAL_II_WITH_MPI
-  N_VDestroy_Parallel(yy);
-  N_VDestroy_Parallel(yp);
-  N_VDestroy_Parallel(abs_tolls);
-  N_VDestroy_Parallel(diff_id);
-#else
-  N_VDestroy_Serial(yy);
-  N_VDestroy_Serial(yp);
-  N_VDestroy_Serial(abs_tolls);
-  N_VDestroy_Serial(diff_id);
-#endif
+  free_vectors();
 
   return step_number;
 }
@@ -359,103 +639,134 @@ void IDAInterface<VEC>::reset_dae(double current_time,
                                   double current_time_step,
                                   bool first_step)
 {
-  if (ida_mem)
-    IDAFree(&ida_mem);
+  int status = 0;
 
-  ida_mem = IDACreate();
+  // IDA can be reinitialized in place only if the layout of the
+  // vectors did not change, otherwise its internal vectors have the
+  // wrong size and the memory has to be created from scratch.
+  const IndexSet locally_owned = solution.locally_owned_elements();
+  const bool same_layout = (ida_mem != nullptr) &&
+                           (yy != nullptr) &&
+                           (solution.size() == system_size) &&
+                           (locally_owned == locally_owned_elements);
 
+  system_size = solution.size();
+  local_system_size = locally_owned.n_elements();
+  locally_owned_elements = locally_owned;
 
-  // Free the vectors which are no longer used.
-  if (yy)
+  // yy and yp are views of the user vectors: IDA reads and writes
+  // directly into solution and solution_dot. Existing vectors are
+  // updated in place.
+  if (yy == nullptr)
     {
 #ifdef DEAL_II_WITH_MPI
-      N_VDestroy_Parallel(yy);
-      N_VDestroy_Parallel(yp);
-      N_VDestroy_Parallel(abs_tolls);
-      N_VDestroy_Parallel(diff_id);
+      yy        = NVectorWrappers::create_view(solution, communicator);
+      yp        = NVectorWrappers::create_view(solution_dot, communicator);
+      diff_id   = NVectorWrappers::create_copy(differential_components(), communicator);
 #else
-      N_VDestroy_Serial(yy);
-      N_VDestroy_Serial(yp);
-      N_VDestroy_Serial(abs_tolls);
-      N_VDestroy_Serial(diff_id);
+      yy        = NVectorWrappers::create_view(solution);
+      yp        = NVectorWrappers::create_view(solution_dot);
+      diff_id   = NVectorWrappers::create_copy(differential_components());
 #endif
     }
+  else
+    {
+      NVectorWrappers::reinit(yy, solution);
+      NVectorWrappers::reinit(yp, solution_dot);
+      NVectorWrappers::reinit(diff_id, differential_components());
+    }
 
-  int status;
-  system_size = solution.size();
+  if (use_local_tolerances)
+    {
+//      VEC tolerances = get_local_tolerances();
+//      VEC abs_tolerances(tolerances);
+//      abs_tolerances /= tolerances.linfty_norm();
+//      abs_tolerances *= abs_tol;
+      if (abs_tolls == nullptr)
 #ifdef DEAL_II_WITH_MPI
-  IndexSet is = solution.locally_owned_elements();
-  local_system_size = is.n_elements();
-
-  yy        = N_VNew_Parallel(communicator,
-                              local_system_size,
-                              system_size);
-
-  yp        = N_VNew_Parallel(communicator,
-                              local_system_size,
-                              system_size);
-
-  diff_id   = N_VNew_Parallel(communicator,
-                              local_system_size,
-                              system_size);
-
-  abs_tolls = N_VNew_Parallel(communicator,
-                              local_system_size,
-                              system_size);
-
+        abs_tolls = NVectorWrappers::create_copy(get_local_tolerances(), communicator);
 #else
-  yy        = N_VNew_Serial(system_size);
-  yp        = N_VNew_Serial(system_size);
-  diff_id   = N_VNew_Serial(system_size);
-  abs_tolls = N_VNew_Serial(system_size);
+        abs_tolls = NVectorWrappers::create_copy(get_local_tolerances());
 #endif
+      else
+        NVectorWrappers::reinit(abs_tolls, get_local_tolerances());
+    }
 
-  copy(yy, solution);
-  copy(yp, solution_dot);
-  copy(diff_id, differential_components());
+  if (linear_solver_type == "custom" &&
+      (!same_layout || !linear_solver_work_vector))
+    linear_solver_work_vector = VectorPool<VEC>::get_pool().get(solution, create_new_vector);
 
-  status = IDAInit(ida_mem, t_dae_residual<VEC>, current_time, yy, yp);
+  // IDA counters restart from zero after IDAReInit and IDAInit
+  if (ida_mem)
+    {
+      update_statistics();
+      counters_offset = statistics;
+    }
+  if (!first_step)
+    ++statistics.n_restarts;
 
-  if (use_local_tolerances)
+  if (same_layout)
     {
-//      VEC tolerances = get_local_tolerances();
-//      VEC abs_tolerances(tolerances);
-//      abs_tolerances /= tolerances.linfty_norm();
-//      abs_tolerances *= abs_tol;
-      copy(abs_tolls, get_local_tolerances());
-      status += IDASVtolerances(ida_mem, rel_tol, abs_tolls);
+      // Options and linear solver hooks survive IDAReInit
+      status += IDAReInit(ida_mem, current_time, yy, yp);
     }
   else
     {
-      status += IDASStolerances(ida_mem, rel_tol, abs_tol);
-    }
+      if (ida_mem)
+        IDAFree(&ida_mem);
 
-  status += IDASetInitStep(ida_mem, current_time_step);
-  status += IDASetUserData(ida_mem, (void *) this);
+      ida_mem = IDACreate();
 
-  status += IDASetId(ida_mem, diff_id);
-  status += IDASetSuppressAlg(ida_mem, ignore_algebraic_terms_for_errors);
+      status += IDAInit(ida_mem, t_dae_residual<VEC>, current_time, yy, yp);
+
+      status += IDASetUserData(ida_mem, (void *) this);
+      status += IDASetSuppressAlg(ida_mem, ignore_algebraic_terms_for_errors);
 
-//  status += IDASetMaxNumSteps(ida_mem, max_steps);
-  status += IDASetStopTime(ida_mem, final_time);
+//      status += IDASetMaxNumSteps(ida_mem, max_steps);
+      status += IDASetStopTime(ida_mem, final_time);
 
-  status += IDASetMaxNonlinIters(ida_mem, max_non_linear_iterations);
+      status += IDASetMaxNonlinIters(ida_mem, max_non_linear_iterations);
 
-  // Initialize solver
-  IDAMem IDA_mem;
-  IDA_mem = (IDAMem) ida_mem;
+      // Initialize solver
+      if (linear_solver_type == "custom")
+        {
+          IDAMem IDA_mem;
+          IDA_mem = (IDAMem) ida_mem;
 
-  IDA_mem->ida_lsetup = t_dae_lsetup<VEC>;
-  IDA_mem->ida_lsolve = t_dae_solve<VEC>;
-  IDA_mem->ida_setupNonNull = true;
+          IDA_mem->ida_lsetup = t_dae_lsetup<VEC>;
+          IDA_mem->ida_lsolve = t_dae_solve<VEC>;
+          IDA_mem->ida_setupNonNull = true;
+        }
+      else
+        status += initialize_krylov_solver();
 
+      status += IDASetMaxOrd(ida_mem, max_order);
+    }
+
+  // IDA keeps its own copies of the tolerances and of the
+  // differential components, which have to be refreshed in both cases.
+  if (use_local_tolerances)
+    status += IDASVtolerances(ida_mem, rel_tol, abs_tolls);
+  else
+    status += IDASStolerances(ida_mem, rel_tol, abs_tol);
+
+  status += IDASetInitStep(ida_mem, current_time_step);
+  status += IDASetId(ida_mem, diff_id);
 
-  status += IDASetMaxOrd(ida_mem, max_order);
+  // Event functions are kept by IDAReInit, but their number may have
+  // changed since the last call.
+  events_found.resize(n_events);
+  if (n_events > 0)
+    status += IDARootInit(ida_mem, n_events, t_dae_events<VEC>);
+  else
+    status += IDARootInit(ida_mem, 0, NULL);
 
   AssertThrow(status == 0, ExcMessage("Error initializing IDA."));
 
   std::string type;
-  if (first_step)
+  if (resuming)
+    type = "none";
+  else if (first_step)
     type = ic_type;
   else
     type = reset_type;
@@ -473,17 +784,11 @@ void IDAInterface<VEC>::reset_dae(double current_time,
       // (re)initialization of the vectors
       IDACalcIC(ida_mem, IDA_Y_INIT, current_time+current_time_step);
       IDAGetConsistentIC(ida_mem, yy, yp);
-
-      copy(solution, yy);
-      copy(solution_dot, yp);
     }
   else if (type == "use_y_diff")
     {
       IDACalcIC(ida_mem, IDA_YA_YDP_INIT, current_time+current_time_step);
       IDAGetConsistentIC(ida_mem, yy, yp);
-
-      copy(solution, yy);
-      copy(solution_dot, yp);
     }
 
   if (verbose)
@@ -493,12 +798,382 @@ void IDAInterface<VEC>::reset_dae(double current_time,
     }
 }
 
+template<typename VEC>
+MPI_Comm IDAInterface<VEC>::get_communicator() const
+{
+#ifdef DEAL_II_WITH_MPI
+  return communicator;
+#else
+  return MPI_COMM_WORLD;
+#endif
+}
+
+template<typename VEC>
+void IDAInterface<VEC>::wait_for_output()
+{
+  output_queue.wait();
+}
+
+template<typename VEC>
+void IDAInterface<VEC>::write_output(const double t,
+                                     const VEC &solution,
+                                     const VEC &solution_dot,
+                                     const unsigned int step_number)
+{
+  CallbackScope scope(statistics.output_step);
+  D2K_INTERNAL_PROFILE_SCOPE("IDA output step");
+  if (!output_queue.is_asynchronous())
+    {
+      output_step(t, solution, solution_dot, step_number);
+      return;
+    }
+
+  // The solution keeps changing while the output is written
+  shared_ptr<VEC> sol = VectorPool<VEC>::get_pool().get(solution, create_new_vector);
+  shared_ptr<VEC> sol_dot = VectorPool<VEC>::get_pool().get(solution, create_new_vector);
+  *sol = solution;
+  *sol_dot = solution_dot;
+  output_queue.push([this, t, sol, sol_dot, step_number] ()
+  {
+    this->output_step(t, *sol, *sol_dot, step_number);
+  });
+}
+
+template<typename VEC>
+void IDAInterface<VEC>::save_checkpoint(const double t,
+                                        const double next_time,
+                                        const unsigned int step_number)
+{
+  using namespace CheckpointUtilities;
+  const MPI_Comm comm = get_communicator();
+  IDAMem IDA_mem = (IDAMem) ida_mem;
+
+  std::ofstream out(get_file_name(checkpoint_file, comm, true).c_str(),
+                    std::ios::binary);
+  write_header(out, "IDAInterface", checkpoint_version,
+               IDA_mem->ida_nst, comm);
+
+  write_value(out, t);
+  write_value(out, next_time);
+  write_value(out, step_number);
+  write_value(out, n_events);
+
+  // State of the BDF method
+  write_value(out, IDA_mem->ida_tn);
+  write_value(out, IDA_mem->ida_hh);
+  write_value(out, IDA_mem->ida_hused);
+  write_value(out, IDA_mem->ida_rr);
+  write_value(out, IDA_mem->ida_cj);
+  write_value(out, IDA_mem->ida_cjlast);
+  write_value(out, IDA_mem->ida_cjold);
+  write_value(out, IDA_mem->ida_cjratio);
+  write_value(out, IDA_mem->ida_ss);
+  write_value(out, IDA_mem->ida_kk);
+  write_value(out, IDA_mem->ida_kused);
+  write_value(out, IDA_mem->ida_knew);
+  write_value(out, IDA_mem->ida_phase);
+  write_value(out, IDA_mem->ida_ns);
+  write_value(out, IDA_mem->ida_nst);
+  write_value(out, IDA_mem->ida_psi);
+  write_value(out, IDA_mem->ida_alpha);
+  write_value(out, IDA_mem->ida_beta);
+  write_value(out, IDA_mem->ida_sigma);
+  write_value(out, IDA_mem->ida_gamma);
+
+  write_vector(out, NVectorWrappers::get<VEC>(yy));
+  write_vector(out, NVectorWrappers::get<VEC>(yp));
+  for (unsigned int j=0; j<MXORDP1; ++j)
+    write_vector(out, NVectorWrappers::get<VEC>(IDA_mem->ida_phi[j]));
+
+  out.close();
+  AssertThrow(out, ExcMessage("Error writing the checkpoint file."));
+
+  commit(checkpoint_file, comm);
+
+  if (verbose)
+    pcout << "Checkpoint saved at t = " << t << std::endl;
+}
+
+template<typename VEC>
+bool IDAInterface<VEC>::load_checkpoint(VEC &solution,
+                                        VEC &solution_dot,
+                                        double &t,
+                                        double &next_time,
+                                        unsigned int &step_number)
+{
+  using namespace CheckpointUtilities;
+  const MPI_Comm comm = get_communicator();
+
+  if (!exists(checkpoint_file, comm))
+    return false;
+
+  std::ifstream in(get_file_name(checkpoint_file, comm).c_str(),
+                   std::ios::binary);
+  read_header(in, "IDAInterface", checkpoint_version, comm);
+
+  read_value(in, t);
+  read_value(in, next_time);
+  read_value(in, step_number);
+
+  unsigned int file_n_events;
+  read_value(in, file_n_events);
+  AssertThrow(file_n_events == n_events,
+              ExcMessage("This checkpoint was written with "
+                         + Utilities::int_to_string(file_n_events)
+                         + " event functions, instead of "
+                         + Utilities::int_to_string(n_events) + "."));
+
+  realtype tn, hh, hused, rr, cj, cjlast, cjold, cjratio, ss;
+  int kk, kused, knew, phase, ns;
+  long int nst;
+  realtype psi[MXORDP1], alpha[MXORDP1], beta[MXORDP1], sigma[MXORDP1], gamma[MXORDP1];
+
+  read_value(in, tn);
+  read_value(in, hh);
+  read_value(in, hused);
+  read_value(in, rr);
+  read_value(in, cj);
+  read_value(in, cjlast);
+  read_value(in, cjold);
+  read_value(in, cjratio);
+  read_value(in, ss);
+  read_value(in, kk);
+  read_value(in, kused);
+  read_value(in, knew);
+  read_value(in, phase);
+  read_value(in, ns);
+  read_value(in, nst);
+  read_value(in, psi);
+  read_value(in, alpha);
+  read_value(in, beta);
+  read_value(in, sigma);
+  read_value(in, gamma);
+
+  read_vector(in, solution);
+  read_vector(in, solution_dot);
+
+  // Create the IDA memory, without computing initial conditions
+  resuming = true;
+  reset_dae(tn, solution, solution_dot, hh, true);
+  resuming = false;
+
+  IDAMem IDA_mem = (IDAMem) ida_mem;
+  for (unsigned int j=0; j<MXORDP1; ++j)
+    read_vector(in, NVectorWrappers::get<VEC>(IDA_mem->ida_phi[j]));
+
+  IDA_mem->ida_tn = tn;
+  IDA_mem->ida_tretlast = t;
+  IDA_mem->ida_hh = hh;
+  IDA_mem->ida_hused = hused;
+  IDA_mem->ida_rr = rr;
+  IDA_mem->ida_cj = cj;
+  IDA_mem->ida_cjlast = cjlast;
+  IDA_mem->ida_cjratio = cjratio;
+  IDA_mem->ida_ss = ss;
+  IDA_mem->ida_kk = kk;
+  IDA_mem->ida_kused = kused;
+  IDA_mem->ida_knew = knew;
+  IDA_mem->ida_phase = phase;
+  IDA_mem->ida_ns = ns;
+  IDA_mem->ida_nst = nst;
+  for (unsigned int j=0; j<MXORDP1; ++j)
+    {
+      IDA_mem->ida_psi[j] = psi[j];
+      IDA_mem->ida_alpha[j] = alpha[j];
+      IDA_mem->ida_beta[j] = beta[j];
+      IDA_mem->ida_sigma[j] = sigma[j];
+      IDA_mem->ida_gamma[j] = gamma[j];
+    }
+
+  // The user Jacobian was never set up in this run: make the ratio
+  // cj/cjold large enough for IDA to call lsetup at the first step.
+  (void) cjold;
+  IDA_mem->ida_cjold = 10.0*cj;
+
+  // IDASolve skips its initial setup when nst > 0, including the
+  // evaluation of the event functions at the initial time, which root
+  // finding compares with their values at the end of the next step.
+  // Mark the last returned time as the time of a root: IDA then
+  // evaluates the event functions there before the next step, and
+  // handles the ones that are zero as after an event.
+  if (n_events > 0)
+    {
+      IDA_mem->ida_tlo = t;
+      IDA_mem->ida_irfnd = 1;
+      for (unsigned int i=0; i<n_events; ++i)
+        IDA_mem->ida_gactive[i] = TRUE;
+    }
+
+  // For the same reason, the linear solver must be initialized here.
+  int status = 0;
+  if (IDA_mem->ida_linit != NULL)
+    status = IDA_mem->ida_linit(IDA_mem);
+  AssertThrow(status == 0, ExcMessage("Error resuming IDA from checkpoint."));
+
+  if (verbose)
+    pcout << "Resumed from checkpoint at t = " << t << std::endl;
+
+  return true;
+}
+
+template<typename VEC>
+void IDAInterface<VEC>::interpolate_solution(const double t,
+                                             VEC &y,
+                                             VEC &y_dot)
+{
+#ifdef DEAL_II_WITH_MPI
+  N_Vector dky = NVectorWrappers::create_view(y, communicator);
+  N_Vector dky_dot = NVectorWrappers::create_view(y_dot, communicator);
+#else
+  N_Vector dky = NVectorWrappers::create_view(y);
+  N_Vector dky_dot = NVectorWrappers::create_view(y_dot);
+#endif
+
+  int status = IDAGetDky(ida_mem, t, 0, dky);
+  status += IDAGetDky(ida_mem, t, 1, dky_dot);
+
+  N_VDestroy(dky);
+  N_VDestroy(dky_dot);
+
+  AssertThrow(status == 0,
+              ExcMessage("Error interpolating the solution at t = "
+                         + Utilities::to_string(t)));
+}
+
+template<typename VEC>
+int IDAInterface<VEC>::initialize_krylov_solver()
+{
+  int status = 0;
+  if (linear_solver_type == "spgmr")
+    {
+      status += IDASpgmr(ida_mem, max_krylov_dimension);
+      status += IDASpilsSetMaxRestarts(ida_mem, max_gmres_restarts);
+    }
+  else if (linear_solver_type == "spbcgs")
+    status += IDASpbcg(ida_mem, max_krylov_dimension);
+  else if (linear_solver_type == "sptfqmr")
+    status += IDASptfqmr(ida_mem, max_krylov_dimension);
+  else
+    AssertThrow(false, ExcMessage("Unknown linear solver type: " + linear_solver_type));
+
+  status += IDASpilsSetEpsLin(ida_mem, krylov_convergence_factor);
+
+  // Without a user supplied product, IDA approximates J*v with
+  // difference quotients of the residual.
+  if (jacobian_vmult)
+    status += IDASpilsSetJacTimesVecFn(ida_mem, t_dae_jtimes<VEC>);
+
+  if (solve_preconditioner)
+    status += IDASpilsSetPreconditioner(ida_mem,
+                                        setup_preconditioner ? t_dae_prec_setup<VEC> : NULL,
+                                        t_dae_prec_solve<VEC>);
+  return status;
+}
+
+template<typename VEC>
+void IDAInterface<VEC>::update_statistics()
+{
+  long int n_steps, n_res, n_setups, n_nonlin, n_nonlin_fails, n_err_fails;
+  int status = 0;
+  status += IDAGetNumSteps(ida_mem, &n_steps);
+  status += IDAGetNumResEvals(ida_mem, &n_res);
+  status += IDAGetNumLinSolvSetups(ida_mem, &n_setups);
+  status += IDAGetNumNonlinSolvIters(ida_mem, &n_nonlin);
+  status += IDAGetNumNonlinSolvConvFails(ida_mem, &n_nonlin_fails);
+  status += IDAGetNumErrTestFails(ida_mem, &n_err_fails);
+  status += IDAGetLastOrder(ida_mem, &statistics.last_order);
+  status += IDAGetLastStep(ida_mem, &statistics.last_step_size);
+  status += IDAGetCurrentTime(ida_mem, &statistics.current_time);
+  status += IDAGetCurrentStep(ida_mem, &statistics.current_step_size);
+
+  long int n_lin = 0;
+  if (linear_solver_type != "custom")
+    status += IDASpilsGetNumLinIters(ida_mem, &n_lin);
+  AssertThrow(status == 0, ExcMessage("Error collecting IDA statistics."));
+
+  statistics.n_linear_iterations = counters_offset.n_linear_iterations + n_lin;
+  statistics.n_steps = counters_offset.n_steps + n_steps;
+  statistics.n_residual_evaluations = counters_offset.n_residual_evaluations + n_res;
+  statistics.n_jacobian_setups = counters_offset.n_jacobian_setups + n_setups;
+  statistics.n_nonlinear_iterations = counters_offset.n_nonlinear_iterations + n_nonlin;
+  statistics.n_nonlinear_convergence_failures = counters_offset.n_nonlinear_convergence_failures + n_nonlin_fails;
+  statistics.n_error_test_failures = counters_offset.n_error_test_failures + n_err_fails;
+}
+
+template<typename VEC>
+const IDAStatistics &IDAInterface<VEC>::get_statistics() const
+{
+  return statistics;
+}
+
+template<typename VEC>
+const IDAStatistics &IDAInterface<VEC>::get_interval_statistics() const
+{
+  return interval_statistics;
+}
+
+template<typename VEC>
+std::size_t IDAInterface<VEC>::memory_consumption() const
+{
+  std::size_t bytes = sizeof(*this);
+  if (ida_mem)
+    {
+      long int lenrw = 0;
+      long int leniw = 0;
+      IDAGetWorkSpace(ida_mem, &lenrw, &leniw);
+      bytes += lenrw*sizeof(realtype) + leniw*sizeof(long int);
+    }
+  return bytes;
+}
+
+template<typename VEC>
+void IDAInterface<VEC>::free_vectors()
+{
+  // IDA memory holds clones of these vectors
+  if (ida_mem)
+    IDAFree(&ida_mem);
+
+  N_Vector *vectors[] = {&yy, &yp, &abs_tolls, &diff_id};
+  for (auto v : vectors)
+    if (*v)
+      {
+        N_VDestroy(*v);
+        *v = nullptr;
+      }
+  linear_solver_work_vector.reset();
+}
+
+template<typename VEC>
+VEC &IDAInterface<VEC>::get_linear_solver_work_vector()
+{
+  Assert(linear_solver_work_vector, ExcNotInitialized());
+  return *linear_solver_work_vector;
+}
+
 template<typename VEC>
 void IDAInterface<VEC>::set_initial_time(const double &t)
 {
   initial_time = t;
 }
 
+template<typename VEC>
+void IDAInterface<VEC>::set_n_events(const unsigned int n)
+{
+  n_events = n;
+}
+
+template<typename VEC>
+unsigned int IDAInterface<VEC>::get_n_events() const
+{
+  return n_events;
+}
+
+template<typename VEC>
+const std::vector<int> &IDAInterface<VEC>::get_events_found() const
+{
+  return events_found;
+}
+
 template<typename VEC>
 void IDAInterface<VEC>::set_functions_to_trigger_an_assert()
 {
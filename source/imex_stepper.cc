@@ -17,6 +17,10 @@
 #include <deal2lkit/imex_stepper.h>
 #ifdef D2K_WITH_SUNDIALS
 
+#include <deal2lkit/checkpoint_utilities.h>
+#include <deal2lkit/vector_pool.h>
+#include <deal2lkit/profiler.h>
+
 #include <deal.II/base/utilities.h>
 #include <deal.II/base/function_parser.h>
 #include <deal.II/lac/block_vector.h>
@@ -32,6 +36,9 @@
 #endif
 #include <deal.II/base/utilities.h>
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
 
@@ -46,6 +53,69 @@ using namespace dealii;
 
 D2K_NAMESPACE_OPEN
 
+// protect the helper functions
+namespace
+{
+  /**
+   * Version of the format of the checkpoint files.
+   */
+  const unsigned int checkpoint_version = 2;
+
+  /**
+   * Butcher tableaux of an IMEX Runge-Kutta scheme, including the
+   * explicit first stage.
+   */
+  struct IMEXTableau
+  {
+    std::vector<double> c;
+    std::vector<std::vector<double> > a_explicit;
+    std::vector<std::vector<double> > a_implicit;
+  };
+
+  /**
+   * Return the tableaux of the IMEX Runge-Kutta @p scheme (Ascher,
+   * Ruuth and Spiteri, 1997), or an empty one if @p scheme is not a
+   * Runge-Kutta scheme. The first stage is explicit, the first column
+   * of the implicit tableau is zero, and both tableaux are stiffly
+   * accurate, i.e., the last stage is the solution.
+   */
+  IMEXTableau get_tableau(const std::string &scheme)
+  {
+    IMEXTableau tableau;
+    if (scheme == "ars222")
+      {
+        const double g = 1. - 1./std::sqrt(2.);
+        const double d = 1. - 1./(2.*g);
+        tableau.c = {0, g, 1};
+        tableau.a_explicit = {{0, 0, 0},
+          {g, 0, 0},
+          {d, 1.-d, 0}
+        };
+        tableau.a_implicit = {{0, 0, 0},
+          {0, g, 0},
+          {0, 1.-g, g}
+        };
+      }
+    else if (scheme == "ars443")
+      {
+        tableau.c = {0, 1./2., 2./3., 1./2., 1};
+        tableau.a_explicit = {{0, 0, 0, 0, 0},
+          {1./2., 0, 0, 0, 0},
+          {11./18., 1./18., 0, 0, 0},
+          {5./6., -5./6., 1./2., 0, 0},
+          {1./4., 7./4., 3./4., -7./4., 0}
+        };
+        tableau.a_implicit = {{0, 0, 0, 0, 0},
+          {0, 1./2., 0, 0, 0},
+          {0, 1./6., 1./2., 0, 0},
+          {0, -1./2., 1./2., 1./2., 0},
+          {0, 3./2., -3./2., 1./2., 1./2.}
+        };
+      }
+    return tableau;
+  }
+}
+
 #ifdef DEAL_II_WITH_MPI
 template <typename VEC>
 IMEXStepper<VEC>::IMEXStepper(std::string name,
@@ -53,6 +123,7 @@ IMEXStepper<VEC>::IMEXStepper(std::string name,
   ParameterAcceptor(name),
   communicator(Utilities::MPI::duplicate_communicator(comm)),
   kinsol("KINSOL for IMEX",comm),
+  alpha_coefficient(1.0),
   pcout(std::cout,
         Utilities::MPI::this_mpi_process(communicator)==0)
 {
@@ -64,6 +135,7 @@ template <typename VEC>
 IMEXStepper<VEC>::IMEXStepper(std::string name) :
   ParameterAcceptor(name),
   kinsol("KINSOL for IMEX"),
+  alpha_coefficient(1.0),
   pcout(std::cout)
 {
   set_functions_to_trigger_an_assert();
@@ -85,7 +157,7 @@ double IMEXStepper<VEC>::get_alpha() const
   if (initial_time == final_time || step_size == 0.0)
     alpha = 0.0;
   else
-    alpha = 1./step_size;
+    alpha = alpha_coefficient/step_size;
 
   return alpha;
 }
@@ -144,16 +216,79 @@ void IMEXStepper<VEC>::declare_parameters(ParameterHandler &prm)
                 "Update continuously Jacobian", "true",
                 Patterns::Bool());
 
+  add_parameter(prm, &lag_jacobian,
+                "Lag Jacobian based on convergence rate", "false",
+                Patterns::Bool(),
+                "If true, the Jacobian (and the preconditioner) is kept across Newton\n"
+                "iterations and time steps, and it is updated only when the Newton method\n"
+                "converges slowly, when the step size changes substantially, or when it\n"
+                "is too old. \"Update continuously Jacobian\" is then ignored. Only used\n"
+                "when \"Use the KINSOL solver\" is false.");
+
+  add_parameter(prm, &max_convergence_rate,
+                "Maximum convergence rate", "0.5",
+                Patterns::Double(0,1),
+                "The Jacobian is updated if the ratio of the norms of two consecutive\n"
+                "Newton updates exceeds this value. Only used when \"Use the KINSOL solver\"\n"
+                "is false.");
+
+  add_parameter(prm, &max_alpha_change,
+                "Maximum relative change of alpha", "0.3",
+                Patterns::Double(0),
+                "The Jacobian is updated if alpha, i.e., the coefficient of the time\n"
+                "derivative, differs by more than this fraction from the one used in\n"
+                "its last update. Only used when \"Use the KINSOL solver\" is false.");
+
+  add_parameter(prm, &max_jacobian_age,
+                "Maximum Jacobian age", "20",
+                Patterns::Integer(1),
+                "Maximum number of time steps between two updates of the Jacobian. Only\n"
+                "used when \"Use the KINSOL solver\" is false.");
+
   add_parameter(prm, &n_max_backtracking,
                 "Number of elements in backtracking sequence", "5",
                 Patterns::Integer(1),
                 "In the line seach method with backtracking the following alphas are\n"
-                "tested: 1, 1/2, 1/4,..., 2^-i. This parameter sets the maximum i.");
+                "tested: 1, 1/2, 1/4,..., 2^-i. This parameter sets the maximum i.\n"
+                "In the line search with interpolation it is the maximum number of\n"
+                "alphas tested after the full step.");
   add_parameter(prm, &method,
                 "Method used", "fixed_alpha",
-                Patterns::Selection("fixed_alpha|LS_backtracking"),
+                Patterns::Selection("fixed_alpha|LS_backtracking|LS_interpolation"),
                 "Fixed alpha means that the parsed alpha is used in each Newton iteration\n"
-                "LS_backtracking is the line search with backtracking method.");
+                "LS_backtracking is the line search with backtracking method.\n"
+                "LS_interpolation is the line search with quadratic and cubic interpolation\n"
+                "and the Armijo condition, which usually needs at most two residuals.\n"
+                "Only used when \"Use the KINSOL solver\" is false: KINSOL uses its own\n"
+                "globalization strategy.");
+
+  add_parameter(prm, &use_forcing_terms,
+                "Use Eisenstat-Walker forcing terms", "true",
+                Patterns::Bool(),
+                "If true, the relative tolerance passed to solve_jacobian_system_with_tolerance\n"
+                "is chosen at each Newton iteration as\n"
+                "  gamma*(|F(y_k)|/|F(y_k-1)|)^exponent,\n"
+                "bounded by the minimum and maximum forcing terms, so that the linear\n"
+                "systems are solved loosely far from the solution. Otherwise the minimum\n"
+                "forcing term is used. It has no effect if only solve_jacobian_system\n"
+                "is provided, and when \"Use the KINSOL solver\" is true, since KINSOL\n"
+                "always receives the minimum forcing term.");
+
+  add_parameter(prm, &max_forcing_term,
+                "Maximum forcing term", "0.5",
+                Patterns::Double(0,1));
+
+  add_parameter(prm, &min_forcing_term,
+                "Minimum forcing term", "1e-8",
+                Patterns::Double(0,1));
+
+  add_parameter(prm, &forcing_term_gamma,
+                "Forcing term gamma", "0.9",
+                Patterns::Double(0,1));
+
+  add_parameter(prm, &forcing_term_exponent,
+                "Forcing term exponent", "2",
+                Patterns::Double(1,2));
 
   add_parameter(prm, &verbose,
                 "Print useful informations", "false",
@@ -163,6 +298,104 @@ void IMEXStepper<VEC>::declare_parameters(ParameterHandler &prm)
                 "Use the KINSOL solver", "true",
                 Patterns::Bool());
 
+  add_parameter(prm, &scheme,
+                "Time stepping scheme", "implicit_euler",
+                Patterns::Selection("implicit_euler|bdf2|sbdf2|ars222|ars443"),
+                "implicit_euler: first order, IMEX Euler if an explicit operator is given\n"
+                "bdf2: second order BDF, fully implicit\n"
+                "sbdf2: second order BDF with linear extrapolation of the explicit operator\n"
+                "ars222: second order IMEX Runge-Kutta ARS(2,2,2)\n"
+                "ars443: third order IMEX Runge-Kutta ARS(4,4,3)\n"
+                "The higher order schemes assume that the residual is linear in y_dot. The\n"
+                "multistep schemes bdf2 and sbdf2 use implicit Euler for the first step,\n"
+                "and for the first one after a restart.");
+
+  add_parameter(prm, &use_adaptive_time_stepping,
+                "Use adaptive time stepping", "false",
+                Patterns::Bool(),
+                "If true, the step size is chosen by a PI controller, from an estimate of\n"
+                "the local error given by the difference with an explicit Euler predictor.\n"
+                "Steps whose error is too large are rejected and repeated with a smaller\n"
+                "step. The \"Step size\" expression is used as the largest step size.");
+
+  add_parameter(prm, &abs_time_tol,
+                "Absolute time error tolerance", "1e-4",
+                Patterns::Double(0));
+
+  add_parameter(prm, &rel_time_tol,
+                "Relative time error tolerance", "1e-3",
+                Patterns::Double(0));
+
+  add_parameter(prm, &min_step_size,
+                "Minimum step size", "1e-8",
+                Patterns::Double(0),
+                "Steps of this size are accepted whatever their error.");
+
+  add_parameter(prm, &step_safety_factor,
+                "Step size safety factor", "0.9",
+                Patterns::Double(0,1));
+
+  add_parameter(prm, &min_step_ratio,
+                "Minimum step size ratio", "0.2",
+                Patterns::Double(0,1),
+                "Smallest ratio between two consecutive step sizes.");
+
+  add_parameter(prm, &max_step_ratio,
+                "Maximum step size ratio", "2",
+                Patterns::Double(1),
+                "Largest ratio between two consecutive step sizes.");
+
+  add_parameter(prm, &max_step_rejections,
+                "Maximum number of step rejections", "10",
+                Patterns::Integer(0));
+
+  add_parameter(prm, &checkpoint_interval,
+                "Checkpoint interval (wall seconds)", "0",
+                Patterns::Double(),
+                "Save the time, the step size and the solution when more than this\n"
+                "many seconds of wall time have passed since the last checkpoint.\n"
+                "A non positive value disables checkpointing.");
+
+  add_parameter(prm, &checkpoint_file,
+                "Checkpoint file prefix", "imex_checkpoint",
+                Patterns::Anything(),
+                "Each process writes the file <prefix>-<rank>.chk");
+
+  add_parameter(prm, &resume_from_checkpoint,
+                "Resume from checkpoint", "false",
+                Patterns::Bool(),
+                "If true and a checkpoint exists, solve_dae() continues from the\n"
+                "checkpoint instead of computing consistent initial conditions.");
+
+  add_parameter(prm, &max_pending_outputs,
+                "Maximum number of pending outputs", "0",
+                Patterns::Integer(0),
+                "Output is done by a background thread, which receives copies of the\n"
+                "solution vectors, while time stepping continues. At most this many\n"
+                "outputs are queued or running; zero means synchronous output. Pending\n"
+                "outputs are written before each call to solver_should_restart(),\n"
+                "which may change anything used by output_step(), e.g., the mesh.\n"
+                "With MPI, asynchronous output requires MPI_THREAD_MULTIPLE, and\n"
+                "output is synchronous otherwise.");
+}
+
+template <typename VEC>
+shared_ptr<VEC> IMEXStepper<VEC>::get_vector(const VEC &model)
+{
+  return VectorPool<VEC>::get_pool().get(model, create_new_vector);
+}
+
+template <typename VEC>
+int IMEXStepper<VEC>::stage_residual(const double t,
+                                     const VEC &y,
+                                     const VEC &y_dot,
+                                     VEC &res)
+{
+  D2K_INTERNAL_PROFILE_SCOPE("IMEX residual");
+  int ret = this->residual(t, y, y_dot, res);
+  if (stage_rhs)
+    res -= *stage_rhs;
+  return ret;
 }
 
 template <typename VEC>
@@ -176,31 +409,104 @@ void IMEXStepper<VEC>::compute_y_dot(const VEC &y, const VEC &prev, const double
 template <typename VEC>
 unsigned int IMEXStepper<VEC>::solve_dae(VEC &solution, VEC &solution_dot)
 {
+  D2K_INTERNAL_PROFILE_SCOPE("IMEX solve dae");
+  AssertThrow(scheme != "bdf2" || !explicit_operator,
+              ExcMessage("bdf2 is fully implicit: use sbdf2 with an explicit operator."));
+  AssertThrow(!use_adaptive_time_stepping || scheme == "implicit_euler",
+              ExcMessage("Adaptive time stepping is only available with implicit_euler."));
+
+  const bool multistep = (scheme == "bdf2" || scheme == "sbdf2");
+  const IMEXTableau tableau = get_tableau(scheme);
+
   unsigned int step_number = 0;
 
-  auto previous_solution = create_new_vector();
-  auto residual_ = create_new_vector();
-  auto rhs = create_new_vector();
+  output_queue.set_max_pending(max_pending_outputs);
+
+  auto previous_solution = get_vector(solution);
+  auto residual_ = get_vector(solution);
+  auto rhs = get_vector(solution);
+
+  // Needed to repeat rejected steps and to estimate the error
+  auto initial_guess = get_vector(solution);
+  auto previous_solution_dot = get_vector(solution);
+  auto error_vector = get_vector(solution);
+  double previous_error = 1.0;
+
+  // Vectors of the higher order schemes, allocated once and reused at
+  // each step. The time derivative is computed with respect to
+  // history, which is previous_solution for the one step schemes.
+  shared_ptr<VEC> history, history_storage, older_solution, zero_vector,
+             explicit_old, explicit_older, rhs_vector;
+  std::vector<shared_ptr<VEC> > explicit_stages(tableau.c.size());
+  std::vector<shared_ptr<VEC> > implicit_stages(tableau.c.size());
+
+  auto allocate_scheme_vectors = [&] ()
+  {
+    history = previous_solution;
+    history_storage = get_vector(solution);
+    older_solution = get_vector(solution);
+    zero_vector = get_vector(solution);
+    explicit_old = get_vector(solution);
+    explicit_older = get_vector(solution);
+    rhs_vector = get_vector(solution);
+    // The first stage is y_n, whose explicit term is explicit_old, and
+    // the implicit term of the last stage is never needed.
+    for (unsigned int i=1; i+1<tableau.c.size(); ++i)
+      {
+        if (explicit_operator)
+          explicit_stages[i] = get_vector(solution);
+        implicit_stages[i] = get_vector(solution);
+      }
+  };
+  allocate_scheme_vectors();
+
+  // Whether previous_solution and older_solution are solutions of
+  // previous steps, rather than backward extrapolations.
+  bool have_previous = false;
+  bool have_older = false;
+  bool explicit_old_is_valid = false;
+  bool explicit_older_is_valid = false;
 
   double t = initial_time;
-  double alpha;
-  step_size = evaluate_step_size(t);
-  alpha = get_alpha();
-  // check if it is a stationary problem
-  if (initial_time == final_time)
-    alpha = 0.0;
-  else
-    alpha = 1./step_size;
+  double stage_time = t;
+  alpha_coefficient = 1.0;
+  stage_rhs.reset();
+
+  std::chrono::steady_clock::time_point last_checkpoint_time =
+    std::chrono::steady_clock::now();
+  double adaptive_step_size = 0;
+  double previous_step_size = 0;
+  const bool resumed = resume_from_checkpoint &&
+                       load_checkpoint(t, step_number,
+                                       solution, solution_dot,
+                                       previous_step_size,
+                                       *older_solution, have_older,
+                                       adaptive_step_size, previous_error);
+
+  if (!resumed)
+    {
+      step_size = evaluate_step_size(t);
+      adaptive_step_size = step_size;
+      previous_step_size = step_size;
+    }
 
-  compute_previous_solution(solution,solution_dot,alpha, *previous_solution);
+  // A checkpoint is taken at the end of a step, when the previous
+  // solution is the current one.
+  if (resumed)
+    {
+      *previous_solution = solution;
+      have_previous = true;
+    }
+  else
+    compute_previous_solution(solution,solution_dot,get_alpha(), *previous_solution);
 
 
 
   std::function<int(const VEC &, VEC &)> my_residual = [&] (const VEC &y, VEC &res)
   {
     double a = this->get_alpha();
-    compute_y_dot(y,*previous_solution,a,solution_dot);
-    int ret = this->residual(t,y,solution_dot,res);
+    compute_y_dot(y,*history,a,solution_dot);
+    int ret = this->stage_residual(stage_time,y,solution_dot,res);
     *residual_ = res;
     AssertThrow(!std::isnan(residual_->l2_norm()),ExcMessage("Residual contains one or more NaNs."));
     return ret;
@@ -209,15 +515,15 @@ unsigned int IMEXStepper<VEC>::solve_dae(VEC &solution, VEC &solution_dot)
   std::function<int(const VEC &)> my_jac = [&] (const VEC &y)
   {
     double a = this->get_alpha();
-    compute_y_dot(y,*previous_solution,a,solution_dot);
-    return this->setup_jacobian(t,y,solution_dot,a);
+    compute_y_dot(y,*history,a,solution_dot);
+    return this->setup_jacobian(stage_time,y,solution_dot,a);
   };
 
   std::function<int(const VEC &, VEC &)> my_solve = [&] (const VEC &, VEC &dst)
   {
     *rhs = *residual_;
     *rhs *= -1.0;
-    return this->solve_jacobian_system(*rhs,dst);
+    return this->solve_linear_system(*rhs,dst,min_forcing_term);
   };
 
 
@@ -231,17 +537,143 @@ unsigned int IMEXStepper<VEC>::solve_dae(VEC &solution, VEC &solution_dot)
   // responsible to keep track of the requirement that the
   // system's Jacobian be updated.
   bool update_Jacobian = true;
+  jacobian_alpha = 0;
+  jacobian_age = 0;
 
   // silence a warning when using kinsol
   (void) update_Jacobian;
 
+  // Solve F(time, y, coefficient/dt*(y - history)) = stage_rhs, starting
+  // from the current solution.
+  auto solve_implicit = [&] (const double time,
+                             const double coefficient)
+  {
+    stage_time = time;
+    alpha_coefficient = coefficient;
+    const double alpha = get_alpha();
+    if (use_kinsol)
+      {
+        kinsol.solve(solution);
+        compute_y_dot(solution,*history,alpha,solution_dot);
+      }
+    else
+      {
+        // The initial guess is the current solution, whose time
+        // derivative must be computed with respect to the new history
+        compute_y_dot(solution,*history,alpha,solution_dot);
+        // The Jacobian depends on alpha, which changes between stages
+        do_newton(stage_time,alpha,update_Jacobian || jacobian_is_outdated(alpha),
+                  *history,solution,solution_dot);
+      }
+  };
+
+  // Advance the solution from previous_solution, at time t-step_size,
+  // to time t.
+  auto do_step = [&] ()
+  {
+    const double dt = step_size;
+    const double t_old = t - dt;
+
+    // The Runge-Kutta schemes need no history, and the first step ends
+    // at the initial time, where the solution is already consistent.
+    // A step of implicit Euler from the backward extrapolation would
+    // change it by O(dt^2), and limit the order to two.
+    if (tableau.c.size() > 0 && !have_previous && initial_time != final_time)
+      return;
+
+    if (explicit_operator && !explicit_old_is_valid)
+      {
+        explicit_operator(t_old, *previous_solution, *explicit_old);
+        explicit_old_is_valid = true;
+      }
+
+    if (tableau.c.size() > 0)
+      {
+        // IMEX Runge-Kutta: every implicit stage solves
+        // F(t_i, Y_i, (Y_i - y_n)/(a_ii dt)) =
+        //   1/a_ii sum_j<i (ae_ij fe(Y_j) - ai_ij fi(Y_j)),
+        // where fi(Y_j) = F(t_j, Y_j, 0) and fe is the explicit operator.
+        history = previous_solution;
+        stage_rhs = rhs_vector;
+        explicit_stages[0] = explicit_old;
+        const unsigned int n_stages = tableau.c.size();
+        for (unsigned int i=1; i<n_stages; ++i)
+          {
+            const double a_ii = tableau.a_implicit[i][i];
+            *rhs_vector = 0;
+            for (unsigned int j=0; j<i; ++j)
+              {
+                if (explicit_operator)
+                  rhs_vector->add(tableau.a_explicit[i][j], *explicit_stages[j]);
+                // the first column of the implicit tableau is zero
+                if (j > 0)
+                  rhs_vector->add(-tableau.a_implicit[i][j], *implicit_stages[j]);
+              }
+            *rhs_vector /= a_ii;
+
+            const double t_i = t_old + tableau.c[i]*dt;
+            solve_implicit(t_i, 1./a_ii);
+
+            if (i+1 < n_stages)
+              {
+                if (explicit_operator)
+                  explicit_operator(t_i, solution, *explicit_stages[i]);
+                this->residual(t_i, solution, *zero_vector, *implicit_stages[i]);
+              }
+          }
+        stage_time = t;
+
+        // The schemes are stiffly accurate: the last stage is the
+        // solution. Its time derivative is approximated by the mean one.
+        alpha_coefficient = 1.0;
+        compute_y_dot(solution, *previous_solution, get_alpha(), solution_dot);
+      }
+    else if (multistep && have_previous && have_older)
+      {
+        // Variable step BDF2: y' = (c y - (1+w) y_n + w^2/(1+w) y_n-1)/dt
+        const double w = dt/previous_step_size;
+        const double c = (1.+2.*w)/(1.+w);
+        history = history_storage;
+        *history = *previous_solution;
+        history->sadd((1.+w)/c, -w*w/((1.+w)*c), *older_solution);
+
+        if (scheme == "sbdf2")
+          {
+            // Linear extrapolation of the explicit operator
+            if (!explicit_older_is_valid)
+              {
+                explicit_operator(t_old - previous_step_size, *older_solution, *explicit_older);
+                explicit_older_is_valid = true;
+              }
+            *rhs_vector = *explicit_old;
+            rhs_vector->sadd(1.+w, -w, *explicit_older);
+            stage_rhs = rhs_vector;
+          }
+        else
+          stage_rhs.reset();
+
+        solve_implicit(t, c);
+      }
+    else
+      {
+        // Implicit Euler, which is IMEX Euler with an explicit operator
+        history = previous_solution;
+        if (explicit_operator)
+          stage_rhs = explicit_old;
+        else
+          stage_rhs.reset();
+        solve_implicit(t, 1.0);
+      }
+  };
+
 
 //   store initial conditions
-  output_step(t, solution, solution_dot,  step_number);
+  if (!resumed)
+    write_output(t, solution, solution_dot,  step_number);
 
   bool restart=false;
 
-  auto L2 = create_new_vector();
+  auto L2 = get_vector(solution);
   if (use_kinsol)
     {
       // call kinsol initialization. this is mandatory if I am doing multiple cycle in pi-DoMUS
@@ -250,9 +682,11 @@ unsigned int IMEXStepper<VEC>::solve_dae(VEC &solution, VEC &solution_dot)
       kinsol.set_scaling_vectors(*L2, *L2);
     }
 
-  compute_consistent_initial_conditions(initial_time,
-                                        solution,
-                                        solution_dot);
+  // The solution stored in a checkpoint is already consistent.
+  if (!resumed)
+    compute_consistent_initial_conditions(initial_time,
+                                          solution,
+                                          solution_dot);
   // The overall cycle over time begins here.
   while (t<=final_time+1e-15)
     {
@@ -260,23 +694,73 @@ unsigned int IMEXStepper<VEC>::solve_dae(VEC &solution, VEC &solution_dot)
             << " (step size = "<< step_size<<")"
             << std::endl;
 
-      if (use_kinsol)
+      *initial_guess = solution;
+      *previous_solution_dot = solution_dot;
+
+      for (unsigned int n_rejections=0; ; ++n_rejections)
         {
-          kinsol.solve(solution);
-          compute_y_dot(solution,*previous_solution,alpha,solution_dot);
+          do_step();
+
+          // The first step starts from a previous solution that is
+          // extrapolated backwards, and it is not controlled.
+          if (!use_adaptive_time_stepping || get_alpha() == 0.0 || step_number == 0)
+            break;
+
+          const double error = estimate_error(solution,
+                                              *previous_solution,
+                                              *previous_solution_dot,
+                                              *error_vector);
+          if (error <= 1.0 ||
+              step_size <= min_step_size ||
+              n_rejections == max_step_rejections)
+            {
+              // The controller needs the error of the last accepted step
+              const double next_step_size =
+                compute_next_step_size(step_size, error, previous_error);
+              previous_error = std::max(error, 1e-10);
+              adaptive_step_size = next_step_size;
+              break;
+            }
+
+          // Reject the step, and repeat it from the same starting point
+          const double new_step_size =
+            std::max(min_step_size,
+                     step_size*std::max(min_step_ratio,
+                                        step_safety_factor/std::sqrt(error)));
+          pcout << "   Step rejected (error = " << error
+                << "), new step size = " << new_step_size << std::endl;
+
+          t += new_step_size - step_size;
+          step_size = new_step_size;
+          // The explicit term at the start of the step does not change
+          solution = *initial_guess;
+          solution_dot = *previous_solution_dot;
         }
-      else
-        do_newton(t,alpha,update_Jacobian,*previous_solution,solution,solution_dot);
 
+      // solver_should_restart() may change what output_step() uses
+      output_queue.wait();
       restart = solver_should_restart(t,solution,solution_dot);
 
+      if (restart)
+        {
+          // The history of the multistep schemes is lost
+          have_previous = false;
+          have_older = false;
+          explicit_old_is_valid = false;
+          explicit_older_is_valid = false;
+        }
+
       while (restart)
         {
 
-          previous_solution = create_new_vector();
-          residual_ = create_new_vector();
-          rhs = create_new_vector();
-          L2 = create_new_vector();
+          previous_solution = get_vector(solution);
+          residual_ = get_vector(solution);
+          rhs = get_vector(solution);
+          L2 = get_vector(solution);
+          initial_guess = get_vector(solution);
+          previous_solution_dot = get_vector(solution);
+          error_vector = get_vector(solution);
+          allocate_scheme_vectors();
 
 
           if (use_kinsol)
@@ -287,11 +771,14 @@ unsigned int IMEXStepper<VEC>::solve_dae(VEC &solution, VEC &solution_dot)
               *L2 = get_lumped_mass_matrix();
               kinsol.set_scaling_vectors(*L2, *L2);
             }
+
+          // The vectors with the old layout are useless
+          VectorPool<VEC>::get_pool().release_unused();
           compute_consistent_initial_conditions(t,
                                                 solution,
                                                 solution_dot);
 
-          compute_previous_solution(solution,solution_dot,alpha,*previous_solution);
+          compute_previous_solution(solution,solution_dot,get_alpha(),*previous_solution);
 
           restart = solver_should_restart(t,solution,solution_dot);
 
@@ -301,24 +788,177 @@ unsigned int IMEXStepper<VEC>::solve_dae(VEC &solution, VEC &solution_dot)
       step_number += 1;
 
       if ((step_number % output_period) == 0)
-        output_step(t, solution, solution_dot,  step_number);
-      step_size = evaluate_step_size(t);
-      t += step_size;
-
-      if (initial_time == final_time)
-        alpha = 0.0;
+        write_output(t, solution, solution_dot,  step_number);
+      previous_step_size = step_size;
+      if (use_adaptive_time_stepping)
+        step_size = std::max(min_step_size,
+                             std::min(adaptive_step_size, evaluate_step_size(t)));
       else
-        alpha = 1./step_size;
+        step_size = evaluate_step_size(t);
+      t += step_size;
 
+      // Shift the history of the multistep schemes without copies
+      if (multistep)
+        {
+          std::swap(older_solution, previous_solution);
+          std::swap(explicit_older, explicit_old);
+          explicit_older_is_valid = explicit_old_is_valid;
+          have_older = have_previous;
+        }
+      explicit_old_is_valid = false;
       *previous_solution = solution;
-      update_Jacobian = update_jacobian_continuously;
+      have_previous = true;
+      update_Jacobian = update_jacobian_continuously && !lag_jacobian;
+      ++jacobian_age;
+
+      if (CheckpointUtilities::interval_elapsed(last_checkpoint_time,
+                                                checkpoint_interval,
+                                                get_communicator()))
+        save_checkpoint(t, step_number, solution, solution_dot,
+                        previous_step_size, *older_solution, have_older,
+                        adaptive_step_size, previous_error);
 
     } // End of the cycle over time.
+
+  output_queue.wait();
   return 0;
 }
 
 
 
+template <typename VEC>
+void IMEXStepper<VEC>::wait_for_output()
+{
+  output_queue.wait();
+}
+
+
+
+template <typename VEC>
+void IMEXStepper<VEC>::write_output(const double t,
+                                    const VEC &solution,
+                                    const VEC &solution_dot,
+                                    const unsigned int step_number)
+{
+  D2K_INTERNAL_PROFILE_SCOPE("IMEX output step");
+  if (!output_queue.is_asynchronous())
+    {
+      output_step(t, solution, solution_dot, step_number);
+      return;
+    }
+
+  // The solution keeps changing while the output is written
+  shared_ptr<VEC> sol = get_vector(solution);
+  shared_ptr<VEC> sol_dot = get_vector(solution);
+  *sol = solution;
+  *sol_dot = solution_dot;
+  output_queue.push([this, t, sol, sol_dot, step_number] ()
+  {
+    this->output_step(t, *sol, *sol_dot, step_number);
+  });
+}
+
+
+
+template <typename VEC>
+MPI_Comm IMEXStepper<VEC>::get_communicator() const
+{
+#ifdef DEAL_II_WITH_MPI
+  return communicator;
+#else
+  return MPI_COMM_WORLD;
+#endif
+}
+
+
+
+template <typename VEC>
+void IMEXStepper<VEC>::save_checkpoint(const double t,
+                                       const unsigned int step_number,
+                                       const VEC &solution,
+                                       const VEC &solution_dot,
+                                       const double previous_step_size,
+                                       const VEC &older_solution,
+                                       const bool have_older,
+                                       const double adaptive_step_size,
+                                       const double previous_error)
+{
+  using namespace CheckpointUtilities;
+  const MPI_Comm comm = get_communicator();
+
+  std::ofstream out(get_file_name(checkpoint_file, comm, true).c_str(),
+                    std::ios::binary);
+  write_header(out, "IMEXStepper", checkpoint_version, step_number, comm);
+  write_value(out, t);
+  write_value(out, step_size);
+  write_value(out, step_number);
+  write_vector(out, solution);
+  write_vector(out, solution_dot);
+
+  // History of the multistep schemes
+  write_value(out, previous_step_size);
+  write_value(out, have_older);
+  if (have_older)
+    write_vector(out, older_solution);
+
+  // State of the step size controller
+  write_value(out, adaptive_step_size);
+  write_value(out, previous_error);
+
+  out.close();
+  AssertThrow(out, ExcMessage("Error writing the checkpoint file."));
+
+  commit(checkpoint_file, comm);
+
+  if (verbose)
+    pcout << "Checkpoint saved at t = " << t << std::endl;
+}
+
+
+
+template <typename VEC>
+bool IMEXStepper<VEC>::load_checkpoint(double &t,
+                                       unsigned int &step_number,
+                                       VEC &solution,
+                                       VEC &solution_dot,
+                                       double &previous_step_size,
+                                       VEC &older_solution,
+                                       bool &have_older,
+                                       double &adaptive_step_size,
+                                       double &previous_error)
+{
+  using namespace CheckpointUtilities;
+  const MPI_Comm comm = get_communicator();
+
+  if (!exists(checkpoint_file, comm))
+    return false;
+
+  std::ifstream in(get_file_name(checkpoint_file, comm).c_str(),
+                   std::ios::binary);
+  read_header(in, "IMEXStepper", checkpoint_version, comm);
+  read_value(in, t);
+  read_value(in, step_size);
+  read_value(in, step_number);
+  read_vector(in, solution);
+  read_vector(in, solution_dot);
+
+  read_value(in, previous_step_size);
+  read_value(in, have_older);
+  if (have_older)
+    read_vector(in, older_solution);
+
+  read_value(in, adaptive_step_size);
+  read_value(in, previous_error);
+
+  if (verbose)
+    pcout << "Resumed from checkpoint at t = " << t
+          << " (step " << step_number << ")" << std::endl;
+
+  return true;
+}
+
+
+
 template <typename VEC>
 double IMEXStepper<VEC>::
 line_search_with_backtracking(const VEC &update,
@@ -329,8 +969,8 @@ line_search_with_backtracking(const VEC &update,
                               VEC &solution_dot,
                               VEC &residual)
 {
-  auto first_trial = create_new_vector();
-  auto first_residual = create_new_vector();
+  auto first_trial = get_vector(solution);
+  auto first_residual = get_vector(solution);
 
   *first_trial = solution;
   double n_alpha = 1.0;
@@ -341,12 +981,12 @@ line_search_with_backtracking(const VEC &update,
   solution_dot -= previous_solution;
   solution_dot *= alpha;
 
-  this->residual(t, *first_trial, solution_dot, *first_residual);
+  stage_residual(t, *first_trial, solution_dot, *first_residual);
 
   double first_res_norm = vector_norm(*first_residual);
 
-  auto second_trial = create_new_vector();
-  auto second_residual = create_new_vector();
+  auto second_trial = get_vector(solution);
+  auto second_residual = get_vector(solution);
 
   for (unsigned int i=1; i<=n_max_backtracking; ++i)
     {
@@ -360,7 +1000,7 @@ line_search_with_backtracking(const VEC &update,
       solution_dot -= previous_solution;
       solution_dot *= alpha;
 
-      this->residual(t, *second_trial, solution_dot, *second_residual);
+      stage_residual(t, *second_trial, solution_dot, *second_residual);
       double second_res_norm = vector_norm(*second_residual);
       if (first_res_norm < second_res_norm)
         {
@@ -392,6 +1032,86 @@ line_search_with_backtracking(const VEC &update,
 }
 
 
+template <typename VEC>
+double IMEXStepper<VEC>::
+line_search_with_interpolation(const VEC &update,
+                               const VEC &previous_solution,
+                               const double &alpha,
+                               const double &t,
+                               VEC &solution,
+                               VEC &solution_dot,
+                               VEC &residual)
+{
+  auto trial = get_vector(solution);
+  auto trial_residual = get_vector(solution);
+
+  // Merit function f(lambda) = |F(y + lambda*update)|^2/2, whose
+  // derivative in zero is -|F(y)|^2 for a Newton direction.
+  const double c = 1e-4;
+  const double norm_0 = vector_norm(residual);
+  const double f_0 = 0.5*norm_0*norm_0;
+  const double slope = -2.0*f_0;
+
+  auto merit = [&] (const double lambda) -> double
+  {
+    *trial = solution;
+    trial->sadd(1.0, lambda, update);
+    compute_y_dot(*trial, previous_solution, alpha, solution_dot);
+    stage_residual(t, *trial, solution_dot, *trial_residual);
+    const double norm = vector_norm(*trial_residual);
+    return 0.5*norm*norm;
+  };
+
+  double lambda = 1.0;
+  double f = merit(lambda);
+  double previous_lambda = 0.0;
+  double previous_f = 0.0;
+
+  for (unsigned int i=1;
+       i<=n_max_backtracking && f > f_0 + c*lambda*slope;
+       ++i)
+    {
+      double new_lambda;
+      if (i == 1)
+        {
+          // Minimum of the quadratic through f_0, slope and f
+          new_lambda = -slope/(2.0*(f - f_0 - slope));
+        }
+      else
+        {
+          // Minimum of the cubic through f_0, slope and the last two
+          // trials
+          const double r = (f - f_0 - lambda*slope)/(lambda*lambda);
+          const double previous_r = (previous_f - f_0 - previous_lambda*slope)/
+                                    (previous_lambda*previous_lambda);
+          const double a = (r - previous_r)/(lambda - previous_lambda);
+          const double b = (lambda*previous_r - previous_lambda*r)/(lambda - previous_lambda);
+          const double discriminant = b*b - 3.0*a*slope;
+
+          if (a == 0.0)
+            new_lambda = -slope/(2.0*b);
+          else if (discriminant < 0.0)
+            new_lambda = 0.5*lambda;
+          else if (b <= 0.0)
+            new_lambda = (-b + std::sqrt(discriminant))/(3.0*a);
+          else
+            new_lambda = -slope/(b + std::sqrt(discriminant));
+        }
+
+      // Do not reduce the step by less than 1/2 or more than 1/10
+      previous_lambda = lambda;
+      previous_f = f;
+      lambda = std::max(0.1*lambda, std::min(0.5*lambda, new_lambda));
+      f = merit(lambda);
+    }
+
+  // solution_dot was computed for the last trial
+  solution = *trial;
+  residual = *trial_residual;
+  return lambda;
+}
+
+
 template <typename VEC>
 void IMEXStepper<VEC>::
 do_newton (const double t,
@@ -401,9 +1121,10 @@ do_newton (const double t,
            VEC &solution,
            VEC &solution_dot)
 {
-  auto solution_update = create_new_vector();
-  auto res = create_new_vector();
-  auto rhs = create_new_vector();
+  D2K_INTERNAL_PROFILE_SCOPE("IMEX newton");
+  auto solution_update = get_vector(solution);
+  auto res = get_vector(solution);
+  auto rhs = get_vector(solution);
 
 
 
@@ -412,7 +1133,7 @@ do_newton (const double t,
   unsigned int inner_iter = 0;
   unsigned int outer_iter = 0;
   unsigned int nonlin_iter = 0;
-  this->residual(t, solution, solution_dot, *res);
+  stage_residual(t, solution, solution_dot, *res);
   double res_norm = 0.0;
   double solution_norm = 0.0;
 
@@ -421,19 +1142,35 @@ do_newton (const double t,
   // if (rel_tol>0.0)
   //   solution_norm = interface.vector_norm(solution);
 
+  // Norms of the residual used by the forcing terms. Note that
+  // res_norm is the norm of the update after the first iteration.
+  double forcing_term = use_forcing_terms ? max_forcing_term : min_forcing_term;
+  double residual_norm = use_forcing_terms ? this->vector_norm(*res) : 0.0;
+  double previous_residual_norm = 0.0;
+
+  // Norm of the previous update, to estimate the convergence rate
+  // when the Jacobian is lagged.
+  double previous_update_norm = 0.0;
+  bool setup_needed = update_Jacobian;
+
   // The nonlinear solver iteration cycle begins here.
   // using a do while approach, we ensure that the system
   // is solved at least once
   do
     {
       outer_iter += 1;
-      if (update_Jacobian == true)
+      if (setup_needed)
         {
           setup_jacobian(t,
                          solution,
                          solution_dot,
                          alpha);
+          jacobian_alpha = alpha;
+          jacobian_age = 0;
+          previous_update_norm = 0.0;
         }
+      // A lagged Jacobian is updated only if the convergence stalls
+      setup_needed = update_Jacobian && !lag_jacobian;
 
       inner_iter = 0;
       while (inner_iter < max_inner_non_linear_iterations &&
@@ -447,7 +1184,7 @@ do_newton (const double t,
           *rhs = *res;
           *rhs *= -1.0;
 
-          solve_jacobian_system(*rhs, *solution_update);
+          solve_linear_system(*rhs, *solution_update, forcing_term);
 
 
           if (method == "LS_backtracking")
@@ -460,6 +1197,16 @@ do_newton (const double t,
                                                            solution_dot,
                                                            *res);
             }
+          else if (method == "LS_interpolation")
+            {
+              newton_alpha = line_search_with_interpolation(*solution_update,
+                                                            previous_solution,
+                                                            alpha,
+                                                            t,
+                                                            solution,
+                                                            solution_dot,
+                                                            *res);
+            }
           else if (method == "fixed_alpha")
             {
               solution.sadd(1.0,
@@ -471,6 +1218,12 @@ do_newton (const double t,
 
           res_norm = vector_norm(*solution_update);
 
+          if (lag_jacobian &&
+              previous_update_norm > 0.0 &&
+              res_norm > max_convergence_rate*previous_update_norm)
+            setup_needed = true;
+          previous_update_norm = res_norm;
+
           AssertThrow(!std::isnan(res->l2_norm()),ExcMessage("Residual contains one or more NaNs."));
 
           if (rel_tol>0.0)
@@ -489,7 +1242,9 @@ do_newton (const double t,
                         << std::setw(19) << std::scientific << solution_norm
                         << "   solution norm\n"
                         << std::setw(19) << newton_alpha
-                        << "   newton alpha\n\n"
+                        << "   newton alpha\n"
+                        << std::setw(19) << forcing_term
+                        << "   linear tolerance\n\n"
                         << std::endl;
                 }
             }
@@ -503,11 +1258,31 @@ do_newton (const double t,
                     << std::setw(19) << std::scientific << res_norm
                     << "   update norm\n"
                     << std::setw(19) << newton_alpha
-                    << "   newton alpha\n\n"
+                    << "   newton alpha\n"
+                    << std::setw(19) << forcing_term
+                    << "   linear tolerance\n\n"
                     << std::endl;
             }
 
-          this->residual(t,solution,solution_dot,*res);
+          // The line searches already computed the residual
+          if (method == "fixed_alpha")
+            stage_residual(t,solution,solution_dot,*res);
+
+          if (use_forcing_terms)
+            {
+              previous_residual_norm = residual_norm;
+              residual_norm = vector_norm(*res);
+              forcing_term = compute_forcing_term(residual_norm,
+                                                  previous_residual_norm,
+                                                  forcing_term);
+            }
+
+          if (lag_jacobian && setup_needed)
+            {
+              if (verbose)
+                pcout << "   slow convergence, updating the Jacobian" << std::endl;
+              break;
+            }
         }
 
       nonlin_iter += inner_iter;
@@ -543,6 +1318,61 @@ do_newton (const double t,
          res_norm > rel_tol*solution_norm);
 }
 
+template <typename VEC>
+double IMEXStepper<VEC>::
+compute_forcing_term(const double res_norm,
+                     const double previous_res_norm,
+                     const double previous_forcing_term) const
+{
+  if (previous_res_norm <= 0.0)
+    return min_forcing_term;
+
+  // Choice 2 of Eisenstat and Walker, "Choosing the forcing terms in
+  // an inexact Newton method" (1996), with their safeguard against
+  // forcing terms that decrease too fast.
+  double eta = forcing_term_gamma *
+               std::pow(res_norm/previous_res_norm, forcing_term_exponent);
+
+  const double safeguard = forcing_term_gamma *
+                           std::pow(previous_forcing_term, forcing_term_exponent);
+  if (safeguard > 0.1)
+    eta = std::max(eta, safeguard);
+
+  return std::min(max_forcing_term, std::max(min_forcing_term, eta));
+}
+
+template <typename VEC>
+bool IMEXStepper<VEC>::
+jacobian_is_outdated(const double alpha) const
+{
+  if (!lag_jacobian)
+    return alpha != jacobian_alpha;
+
+  if (jacobian_age >= max_jacobian_age)
+    return true;
+
+  if (alpha == jacobian_alpha)
+    return false;
+
+  // Stationary problems and initial conditions use alpha=0
+  if (jacobian_alpha == 0.0 || alpha == 0.0)
+    return true;
+
+  return std::abs(alpha/jacobian_alpha - 1.0) > max_alpha_change;
+}
+
+template <typename VEC>
+int IMEXStepper<VEC>::
+solve_linear_system(const VEC &rhs,
+                    VEC &dst,
+                    const double tolerance)
+{
+  D2K_INTERNAL_PROFILE_SCOPE("IMEX solve jacobian system");
+  if (solve_jacobian_system_with_tolerance)
+    return solve_jacobian_system_with_tolerance(rhs, dst, tolerance);
+  return solve_jacobian_system(rhs, dst);
+}
+
 template <typename VEC>
 void IMEXStepper<VEC>::
 compute_previous_solution(const VEC &sol,
@@ -567,33 +1397,78 @@ compute_previous_solution(const VEC &sol,
 template <typename VEC>
 double IMEXStepper<VEC>::evaluate_step_size(const double &t)
 {
-  std::string variables = "t";
-  std::map<std::string,double> constants;
-  // FunctionParser with 1 variables and 1 component:
-  FunctionParser<1> fp(1);
-  fp.initialize(variables,
-                _step_size,
-                constants);
+  // parse the expression only once
+  if (!step_size_function || parsed_step_size != _step_size)
+    {
+      std::string variables = "t";
+      std::map<std::string,double> constants;
+      // FunctionParser with 1 variables and 1 component:
+      step_size_function = SP(new FunctionParser<1>(1));
+      step_size_function->initialize(variables,
+                                     _step_size,
+                                     constants);
+      parsed_step_size = _step_size;
+    }
   // Point at which we want to evaluate the function
   Point<1> time(t);
   // evaluate the expression at 'time':
-  double result = fp.value(time);
+  double result = step_size_function->value(time);
   return result;
 }
 
+template <typename VEC>
+double IMEXStepper<VEC>::estimate_error(const VEC &sol,
+                                        const VEC &prev,
+                                        const VEC &prev_dot,
+                                        VEC &tmp)
+{
+  // The local error of implicit Euler is half the difference with the
+  // explicit Euler predictor prev + dt*prev_dot.
+  tmp = sol;
+  tmp -= prev;
+  tmp.add(-step_size, prev_dot);
+  const double error = 0.5*vector_norm(tmp);
+  return error/(abs_time_tol + rel_time_tol*vector_norm(sol));
+}
+
+template <typename VEC>
+double IMEXStepper<VEC>::compute_next_step_size(const double dt,
+                                                const double error,
+                                                const double previous_error) const
+{
+  // PI controller for an error estimate of order 2
+  const double e = std::max(error, 1e-10);
+  const double factor = step_safety_factor *
+                        std::pow(e, -0.35) *
+                        std::pow(previous_error, 0.2);
+  return dt*std::min(max_step_ratio, std::max(min_step_ratio, factor));
+}
+
 template <typename VEC>
 void IMEXStepper<VEC>::compute_consistent_initial_conditions(const double &t,
     VEC &y,
     VEC &y_dot)
 {
-  auto previous_solution = create_new_vector();
-  auto first_guess = create_new_vector();
-  auto first_guess_dot = create_new_vector();
-  auto update = create_new_vector();
+  auto previous_solution = get_vector(y);
+  auto first_guess = get_vector(y);
+  auto first_guess_dot = get_vector(y);
+  auto update = get_vector(y);
 
   *first_guess     = y;
   *first_guess_dot = y_dot;
 
+  // The explicit operator is evaluated at the initial solution, so that
+  // initial conditions that are already consistent are not changed
+  auto explicit_term = get_vector(y);
+  if (explicit_operator)
+    {
+      explicit_operator(t, y, *explicit_term);
+      stage_rhs = explicit_term;
+    }
+  else
+    stage_rhs.reset();
+  alpha_coefficient = 1.0;
+
 
 
   step_size = 0;
@@ -603,6 +1478,7 @@ void IMEXStepper<VEC>::compute_consistent_initial_conditions(const double &t,
     }
   else
     do_newton(t,0.0,true,*previous_solution,y,y_dot);
+  stage_rhs.reset();
 
   *update = y;
   *update -= *first_guess;
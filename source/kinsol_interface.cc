@@ -34,7 +34,12 @@
 #endif
 
 #include <deal2lkit/utilities.h>
+#include <deal2lkit/vector_pool.h>
+#include <deal2lkit/profiler.h>
 #include <kinsol/kinsol_dense.h>
+#include <kinsol/kinsol_spgmr.h>
+#include <kinsol/kinsol_spbcgs.h>
+#include <kinsol/kinsol_sptfqmr.h>
 
 D2K_NAMESPACE_OPEN
 
@@ -48,17 +53,18 @@ namespace
   {
 
     KINSOLInterface<VEC> &solver = *static_cast<KINSOLInterface<VEC> *>(user_data);
+    CallbackScope scope(solver.statistics.residual);
+    D2K_INTERNAL_PROFILE_SCOPE("KINSOL residual");
 
+    VEC &loc_y = solver.get_work_vector(KINSOLInterface<VEC>::work_y);
+    VEC &loc_res = solver.get_work_vector(KINSOLInterface<VEC>::work_residual);
 
-    shared_ptr<VEC> loc_y = solver.create_new_vector();
-    shared_ptr<VEC> loc_res = solver.create_new_vector();
+    copy(loc_y, y);
+    copy(loc_res, res);
 
-    copy(*loc_y, y);
-    copy(*loc_res, res);
+    int ret = solver.residual(loc_y, loc_res);
 
-    int ret = solver.residual(*loc_y, *loc_res);
-
-    copy(res, *loc_res);
+    copy(res, loc_res);
     return ret;
   }
 
@@ -67,11 +73,13 @@ namespace
   int kinsol_setup_jacobian( KINMem kin_mem )
   {
     KINSOLInterface<VEC> &solver = *static_cast<KINSOLInterface<VEC> *> (kin_mem->kin_user_data);
+    CallbackScope scope(solver.statistics.setup_jacobian);
+    D2K_INTERNAL_PROFILE_SCOPE("KINSOL setup jacobian");
 
-    shared_ptr<VEC> loc_y = solver.create_new_vector();
+    VEC &loc_y = solver.get_work_vector(KINSOLInterface<VEC>::work_y);
 
-    copy( *loc_y, kin_mem->kin_uu );
-    int err = solver.setup_jacobian( *loc_y );
+    copy( loc_y, kin_mem->kin_uu );
+    int err = solver.setup_jacobian( loc_y );
     return err;
   }
 
@@ -85,20 +93,38 @@ namespace
   {
     KINSOLInterface<VEC> &solver = *static_cast<KINSOLInterface<VEC> *> (kin_mem->kin_user_data);
 
-    //shared_ptr<VEC> loc_y   = solver.create_new_vector();
-    shared_ptr<VEC> loc_res = solver.create_new_vector();
-    shared_ptr<VEC> dst     = solver.create_new_vector();
-    shared_ptr<VEC> loc_b   = solver.create_new_vector();
+    VEC &loc_res = solver.get_work_vector(KINSOLInterface<VEC>::work_residual);
+    VEC &dst     = solver.get_work_vector(KINSOLInterface<VEC>::work_update);
+
+    copy( loc_res, kin_mem->kin_fval);
+
+    int err;
+    {
+      CallbackScope scope(solver.statistics.solve_linear_system);
+      D2K_INTERNAL_PROFILE_SCOPE("KINSOL solve linear system");
+      err = solver.solve_linear_system(loc_res, dst );
+    }
 
-    //copy( *loc_y, x );
-    copy( *loc_res, kin_mem->kin_fval);
+    copy(x, dst);
 
-    int err = solver.solve_linear_system(*loc_res, *dst );
+    if (!solver.needs_jacobian_vmult())
+      {
+        // J*x = -F: the line search quantities follow from the norm of
+        // the residual, which KINSOL already computed. Picard iterations
+        // do not use them at all.
+        *sJpnorm = kin_mem->kin_fnorm;
+        *sFdotJp = -kin_mem->kin_fnorm*kin_mem->kin_fnorm;
+        return err;
+      }
 
-    copy(x, *dst);
-    err += solver.jacobian_vmult( *dst, *loc_b );
+    VEC &loc_b = solver.get_work_vector(KINSOLInterface<VEC>::work_jacobian_vmult);
+    {
+      CallbackScope scope(solver.statistics.jacobian_vmult);
+      D2K_INTERNAL_PROFILE_SCOPE("KINSOL jacobian vmult");
+      err += solver.jacobian_vmult( dst, loc_b );
+    }
 
-    copy(b, *loc_b);
+    copy(b, loc_b);
 
     *sJpnorm = N_VWL2Norm(b, kin_mem->kin_fscale);
     N_VProd(b, kin_mem->kin_fscale, b);
@@ -108,6 +134,93 @@ namespace
 
   }
 
+  /**
+   * helper function to interface jacobian_vmult to the Krylov solvers
+   * of sundials. The Jacobian is set up again whenever the current
+   * solution changes.
+   */
+  template<typename VEC>
+  int kinsol_jtimes(N_Vector v,
+                    N_Vector Jv,
+                    N_Vector uu,
+                    booleantype *new_uu,
+                    void *user_data)
+  {
+    KINSOLInterface<VEC> &solver = *static_cast<KINSOLInterface<VEC> *>(user_data);
+
+    int err = 0;
+    if (*new_uu)
+      {
+        CallbackScope scope(solver.statistics.setup_jacobian);
+        D2K_INTERNAL_PROFILE_SCOPE("KINSOL setup jacobian");
+        VEC &loc_y = solver.get_work_vector(KINSOLInterface<VEC>::work_y);
+        copy(loc_y, uu);
+        err += solver.setup_jacobian(loc_y);
+        *new_uu = false;
+      }
+
+    CallbackScope scope(solver.statistics.jacobian_vmult);
+    D2K_INTERNAL_PROFILE_SCOPE("KINSOL jacobian vmult");
+    VEC &src = solver.get_work_vector(KINSOLInterface<VEC>::work_update);
+    VEC &dst = solver.get_work_vector(KINSOLInterface<VEC>::work_jacobian_vmult);
+    copy(src, v);
+    err += solver.jacobian_vmult(src, dst);
+    copy(Jv, dst);
+    return err;
+  }
+
+  /** helper function to interface setup_preconditioner to sundials */
+  template<typename VEC>
+  int kinsol_prec_setup(N_Vector uu,
+                        N_Vector uscale,
+                        N_Vector fval,
+                        N_Vector fscale,
+                        void *user_data,
+                        N_Vector tmp1,
+                        N_Vector tmp2)
+  {
+    (void) uscale;
+    (void) fval;
+    (void) fscale;
+    (void) tmp1;
+    (void) tmp2;
+    KINSOLInterface<VEC> &solver = *static_cast<KINSOLInterface<VEC> *>(user_data);
+    CallbackScope scope(solver.statistics.setup_preconditioner);
+    D2K_INTERNAL_PROFILE_SCOPE("KINSOL setup preconditioner");
+
+    VEC &loc_y = solver.get_work_vector(KINSOLInterface<VEC>::work_y);
+    copy(loc_y, uu);
+    return solver.setup_preconditioner(loc_y);
+  }
+
+  /** helper function to interface solve_preconditioner to sundials */
+  template<typename VEC>
+  int kinsol_prec_solve(N_Vector uu,
+                        N_Vector uscale,
+                        N_Vector fval,
+                        N_Vector fscale,
+                        N_Vector vv,
+                        void *user_data,
+                        N_Vector tmp)
+  {
+    (void) uu;
+    (void) uscale;
+    (void) fval;
+    (void) fscale;
+    (void) tmp;
+    KINSOLInterface<VEC> &solver = *static_cast<KINSOLInterface<VEC> *>(user_data);
+    CallbackScope scope(solver.statistics.solve_preconditioner);
+    D2K_INTERNAL_PROFILE_SCOPE("KINSOL solve preconditioner");
+
+    // vv is both the right hand side and the result
+    VEC &rhs = solver.get_work_vector(KINSOLInterface<VEC>::work_residual);
+    VEC &dst = solver.get_work_vector(KINSOLInterface<VEC>::work_update);
+    copy(rhs, vv);
+    int err = solver.solve_preconditioner(rhs, dst);
+    copy(vv, dst);
+    return err;
+  }
+
 }
 
 template <typename VEC>
@@ -233,8 +346,20 @@ void KINSOLInterface<VEC>::declare_parameters(ParameterHandler &prm)
                 Patterns::Selection("newton|global_newton|fixed_point|picard"),
                 "newton        = basic Newton iteration \n"
                 "global_newton = Newton with line search \n"
-                "fixed_point   = fixed-point iteration with Anderson Acceleration \n"
-                "picard        = Picard iteration with Anderson Acceleration");
+                "fixed_point   = fixed-point iteration with Anderson Acceleration. In this\n"
+                "                case residual() must compute the fixed-point function G(u),\n"
+                "                and no linear solver is used \n"
+                "picard        = Picard iteration with Anderson Acceleration. The operator\n"
+                "                set up by setup_jacobian() is used by solve_linear_system(),\n"
+                "                and it is rebuilt every \"Maximum number of iteration before\n"
+                "                Jacobian update\" iterations");
+
+  add_parameter(prm, &anderson_subspace_size,
+                "Anderson acceleration subspace size", "0",
+                Patterns::Integer(0),
+                "Number of previous iterations used by the Anderson acceleration of the\n"
+                "fixed_point and picard strategies. 0 disables the acceleration. It must\n"
+                "be smaller than the maximum number of iterations.");
 
   add_parameter(prm, &mbset,
                 "Maximum number of iteration before Jacobian update", "10",
@@ -242,11 +367,57 @@ void KINSOLInterface<VEC>::declare_parameters(ParameterHandler &prm)
                 "Maximum number of nonlinear iterations that can be done with an outdated Jacobian.\n"
                 "If set to 1 the Jacobian is updated at each nonlinear iteration");
 
+  add_parameter(prm, &linear_solver_type,
+                "Linear solver", "custom",
+                Patterns::Selection("custom|spgmr|spbcgs|sptfqmr"),
+                "Linear solver used in the Newton iterations, unless the internal\n"
+                "direct solver is used:\n"
+                " custom: setup_jacobian() and solve_linear_system() are provided by the user\n"
+                " spgmr: Jacobian-free GMRES of KINSOL\n"
+                " spbcgs: Jacobian-free BiCGStab of KINSOL\n"
+                " sptfqmr: Jacobian-free TFQMR of KINSOL\n"
+                "The Krylov solvers only use the optional setup_preconditioner() and\n"
+                "solve_preconditioner(). The preconditioner is set up again every\n"
+                "\"Maximum number of iteration before Jacobian update\" iterations.");
+
+  add_parameter(prm, &jacobian_product,
+                "Jacobian times vector product", "difference_quotient",
+                Patterns::Selection("difference_quotient|user"),
+                "Product used by the Krylov solvers:\n"
+                " difference_quotient: directional derivatives of residual()\n"
+                " user: jacobian_vmult(), after setup_jacobian() is called with the\n"
+                "    current solution");
+
+  add_parameter(prm, &max_krylov_dimension,
+                "Maximum Krylov subspace dimension", "0",
+                Patterns::Integer(0),
+                "Maximum dimension of the Krylov subspace. 0 means the KINSOL default (10).");
+
+  add_parameter(prm, &max_gmres_restarts,
+                "Maximum number of GMRES restarts", "0",
+                Patterns::Integer(0));
+
+  add_parameter(prm, &exact_linear_solves,
+                "Assume exact linear solves", "false",
+                Patterns::Bool(),
+                "If true, the linear systems are assumed to be solved exactly, i.e., the\n"
+                "Newton step p satisfies J p = -F. The quantities needed by the line search\n"
+                "are then computed from the norm of the residual, and jacobian_vmult is\n"
+                "not called. Leave it to false with inexact (e.g., iterative) linear solvers.");
+
   add_parameter(prm, &use_internal_solver,
                 "Use internal KINSOL direct solver", "false",
                 Patterns::Bool(),
                 "If true the dense direct linear solver of KINSOL is used");
 
+  add_parameter(prm, &statistics_format,
+                "Statistics format", "none",
+                Patterns::Selection("none|table|json"),
+                "Print the solver statistics at the end of each solve():\n"
+                " none: do not print anything\n"
+                " table: print a human readable table\n"
+                " json: print a single JSON object");
+
 }
 
 // Initialization of the solver:
@@ -305,6 +476,16 @@ void KINSOLInterface<VEC>::initialize_solver( VEC &initial_guess )
   status = KINSetScaledStepTol(kin_mem, steptol);
   Assert(status == KIN_SUCCESS, ExcMessage("Error initializing KINSOL. KINSetFuncNormTol failed."));
 
+  // The Anderson acceleration memory is allocated by KINInit
+  if (strategy == "fixed_point" || strategy == "picard")
+    {
+      AssertThrow(anderson_subspace_size < max_iterations,
+                  ExcMessage("The Anderson acceleration subspace must be smaller "
+                             "than the maximum number of iterations."));
+      status = KINSetMAA(kin_mem, anderson_subspace_size);
+      AssertThrow(status == KIN_SUCCESS, ExcMessage("Error initializing KINSOL. KINSetMAA failed."));
+    }
+
   // initialize with the helper function:
   status = KINInit(kin_mem, kinsol_residual<VEC> , solution);
   Assert(status == KIN_SUCCESS, ExcMessage("Error initializing KINSOL. KINInit failed."));
@@ -319,7 +500,7 @@ void KINSOLInterface<VEC>::initialize_solver( VEC &initial_guess )
 
   if (use_internal_solver)
     status = KINDense(kin_mem, system_size );
-  else
+  else if (linear_solver_type == "custom")
     {
       KINMem KIN_mem;
       KIN_mem = (KINMem) kin_mem;
@@ -327,6 +508,15 @@ void KINSOLInterface<VEC>::initialize_solver( VEC &initial_guess )
       KIN_mem->kin_lsolve = kinsol_solve_linear_system<VEC>;
       KIN_mem->kin_setupNonNull = true;
     }
+  else
+    status = initialize_krylov_solver();
+  AssertThrow(status == KIN_SUCCESS, ExcMessage("Error initializing the KINSOL linear solver."));
+  // Work vectors of the callbacks, which have the layout of the
+  // initial guess.
+  work_vectors.resize(n_work_vectors);
+  for (auto &v : work_vectors)
+    v = VectorPool<VEC>::get_pool().get(initial_guess, create_new_vector);
+
   is_initialized = true;
 
   (void)status;
@@ -361,6 +551,9 @@ int KINSOLInterface<VEC>::solve( VEC &sol )
     }
 
 
+  statistics = KINSOLStatistics();
+  counters_offset = KINSOLStatistics();
+
   // call to KINSol:
   if (strategy == "newton")
     status = KINSol(kin_mem, this->solution, KIN_NONE, u_scale, f_scale);
@@ -371,6 +564,8 @@ int KINSOLInterface<VEC>::solve( VEC &sol )
   if (strategy == "picard")
     status = KINSol(kin_mem, this->solution, KIN_PICARD, u_scale, f_scale);
 
+  update_statistics();
+
   if (status == KIN_MXNEWT_5X_EXCEEDED)
     {
       // we get here when the inequality
@@ -381,11 +576,11 @@ int KINSOLInterface<VEC>::solve( VEC &sol )
       // or the real scalar mxnewtstep is too small.
       // So we rescale the mxnewtstep to the residual norm
       // and give to kinsol another try
-      auto res = create_new_vector();
+      VEC &res = get_work_vector(work_residual);
       KINMem KIN_mem;
       KIN_mem = (KINMem) kin_mem;
-      copy(*res, KIN_mem->kin_fval);
-      KINSetMaxNewtonStep(kin_mem, res->l2_norm());
+      copy(res, KIN_mem->kin_fval);
+      KINSetMaxNewtonStep(kin_mem, res.l2_norm());
 
       pcout << "Don't worry. This might be only a problem of scaling... Let's try."
             << std::endl;
@@ -395,7 +590,14 @@ int KINSOLInterface<VEC>::solve( VEC &sol )
       if (strategy == "global_newton")
         status = KINSol(kin_mem, this->solution, KIN_LINESEARCH, u_scale, f_scale);
 
+      // KINSol resets its counters at each call
+      counters_offset = statistics;
+      update_statistics();
     }
+
+  if (pcout.is_active())
+    statistics.print(pcout.get_stream(), statistics_format, "KINSOL statistics");
+
   AssertThrow(status >= 0 , ExcMessage("KINSOL did not converge. You might try with a different strategy."));
 
   copy( sol, this->solution );
@@ -404,6 +606,93 @@ int KINSOLInterface<VEC>::solve( VEC &sol )
 
 }
 
+template <typename VEC>
+int KINSOLInterface<VEC>::initialize_krylov_solver()
+{
+  int status = 0;
+  if (linear_solver_type == "spgmr")
+    {
+      status += KINSpgmr(kin_mem, max_krylov_dimension);
+      status += KINSpilsSetMaxRestarts(kin_mem, max_gmres_restarts);
+    }
+  else if (linear_solver_type == "spbcgs")
+    status += KINSpbcg(kin_mem, max_krylov_dimension);
+  else if (linear_solver_type == "sptfqmr")
+    status += KINSptfqmr(kin_mem, max_krylov_dimension);
+  else
+    AssertThrow(false, ExcMessage("Unknown linear solver type: " + linear_solver_type));
+
+  // Without a user supplied product, KINSOL approximates J*v with
+  // difference quotients of the residual.
+  if (jacobian_product == "user")
+    status += KINSpilsSetJacTimesVecFn(kin_mem, kinsol_jtimes<VEC>);
+
+  if (solve_preconditioner)
+    status += KINSpilsSetPreconditioner(kin_mem,
+                                        setup_preconditioner ? kinsol_prec_setup<VEC> : NULL,
+                                        kinsol_prec_solve<VEC>);
+  return status;
+}
+
+template <typename VEC>
+void KINSOLInterface<VEC>::update_statistics()
+{
+  long int n_nonlin, n_fevals, n_beta_fails, n_backtracks;
+  int status = 0;
+  status += KINGetNumNonlinSolvIters(kin_mem, &n_nonlin);
+  status += KINGetNumFuncEvals(kin_mem, &n_fevals);
+  status += KINGetNumBetaCondFails(kin_mem, &n_beta_fails);
+  status += KINGetNumBacktrackOps(kin_mem, &n_backtracks);
+  status += KINGetFuncNorm(kin_mem, &statistics.residual_norm);
+  status += KINGetStepLength(kin_mem, &statistics.step_length);
+  AssertThrow(status == KIN_SUCCESS, ExcMessage("Error collecting KINSOL statistics."));
+
+  long int n_lin = 0;
+  if (!use_internal_solver && linear_solver_type != "custom")
+    {
+      status = KINSpilsGetNumLinIters(kin_mem, &n_lin);
+      AssertThrow(status == KIN_SUCCESS, ExcMessage("Error collecting KINSOL statistics."));
+    }
+  statistics.n_linear_iterations = counters_offset.n_linear_iterations + n_lin;
+  statistics.n_nonlinear_iterations = counters_offset.n_nonlinear_iterations + n_nonlin;
+  statistics.n_residual_evaluations = counters_offset.n_residual_evaluations + n_fevals;
+  statistics.n_beta_condition_failures = counters_offset.n_beta_condition_failures + n_beta_fails;
+  statistics.n_backtrack_operations = counters_offset.n_backtrack_operations + n_backtracks;
+}
+
+template <typename VEC>
+VEC &KINSOLInterface<VEC>::get_work_vector(const unsigned int i)
+{
+  AssertIndexRange(i, work_vectors.size());
+  return *work_vectors[i];
+}
+
+template <typename VEC>
+bool KINSOLInterface<VEC>::needs_jacobian_vmult() const
+{
+  return !exact_linear_solves && strategy != "picard";
+}
+
+template <typename VEC>
+const KINSOLStatistics &KINSOLInterface<VEC>::get_statistics() const
+{
+  return statistics;
+}
+
+template <typename VEC>
+std::size_t KINSOLInterface<VEC>::memory_consumption() const
+{
+  std::size_t bytes = sizeof(*this);
+  if (kin_mem)
+    {
+      long int lenrw = 0;
+      long int leniw = 0;
+      KINGetWorkSpace(kin_mem, &lenrw, &leniw);
+      bytes += lenrw*sizeof(realtype) + leniw*sizeof(long int);
+    }
+  return bytes;
+}
+
 template <typename VEC>
 void KINSOLInterface<VEC>::set_scaling_vectors( const VEC &uscale, const VEC &fscale )
 {
@@ -0,0 +1,102 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#include <deal2lkit/memory_monitor.h>
+
+#include <algorithm>
+#include <iomanip>
+
+D2K_NAMESPACE_OPEN
+
+MemoryMonitor::MemoryMonitor(const MPI_Comm comm) :
+  comm(comm)
+{}
+
+
+
+void MemoryMonitor::checkpoint(const std::string &name)
+{
+  Utilities::System::MemoryStats stats;
+  Utilities::System::get_memory_stats(stats);
+  checkpoints.push_back(std::make_pair(name, stats));
+}
+
+
+
+void MemoryMonitor::add_component(const std::string &name,
+                                  const std::size_t bytes)
+{
+  components.push_back(std::make_pair(name, bytes));
+}
+
+
+
+void MemoryMonitor::clear()
+{
+  checkpoints.clear();
+  components.clear();
+}
+
+
+
+void MemoryMonitor::print_summary(std::ostream &out) const
+{
+  // Name and megabytes of every entry
+  std::vector<std::pair<std::string, double> > entries;
+  for (const auto &c : checkpoints)
+    {
+      entries.push_back(std::make_pair(c.first + " (RSS)", c.second.VmRSS/1024.));
+      entries.push_back(std::make_pair(c.first + " (peak RSS)", c.second.VmHWM/1024.));
+    }
+  for (const auto &c : components)
+    entries.push_back(std::make_pair(c.first, c.second/1024./1024.));
+
+  std::vector<Utilities::MPI::MinMaxAvg> results;
+  for (const auto &e : entries)
+    results.push_back(Utilities::MPI::min_max_avg(e.second, comm));
+
+  if (Utilities::MPI::this_mpi_process(comm) != 0)
+    return;
+
+  std::size_t width = 5;
+  for (const auto &e : entries)
+    width = std::max(width, e.first.size());
+
+  const std::ios_base::fmtflags flags = out.flags();
+  const std::streamsize precision = out.precision();
+
+  const std::string line(width + 3*13, '-');
+  out << line << std::endl
+      << std::left << std::setw(width) << "Entry"
+      << std::right
+      << std::setw(13) << "Min (MB)"
+      << std::setw(13) << "Avg (MB)"
+      << std::setw(13) << "Max (MB)" << std::endl
+      << line << std::endl;
+
+  for (unsigned int i=0; i<entries.size(); ++i)
+    out << std::left << std::setw(width) << entries[i].first
+        << std::right << std::fixed << std::setprecision(2)
+        << std::setw(13) << results[i].min
+        << std::setw(13) << results[i].avg
+        << std::setw(13) << results[i].max << std::endl;
+
+  out << line << std::endl;
+
+  out.flags(flags);
+  out.precision(precision);
+}
+
+D2K_NAMESPACE_CLOSE
@@ -0,0 +1,184 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#include <deal2lkit/output_queue.h>
+
+#include <deal.II/base/mpi.h>
+
+D2K_NAMESPACE_OPEN
+
+// protect the helper functions
+namespace
+{
+  /**
+   * Return @p max_pending if tasks can run in a background thread, and
+   * zero otherwise. Tasks may communicate, which requires MPI to be
+   * initialized with MPI_THREAD_MULTIPLE.
+   */
+  unsigned int supported_max_pending(const unsigned int max_pending)
+  {
+#ifdef DEAL_II_WITH_MPI
+    int initialized, finalized;
+    MPI_Initialized(&initialized);
+    MPI_Finalized(&finalized);
+    if (initialized && !finalized)
+      {
+        int provided;
+        MPI_Query_thread(&provided);
+        if (provided != MPI_THREAD_MULTIPLE)
+          return 0;
+      }
+#endif
+    return max_pending;
+  }
+}
+
+
+
+OutputQueue::OutputQueue(const unsigned int max_pending) :
+  max_pending(supported_max_pending(max_pending)),
+  busy(false),
+  stop(false)
+{}
+
+
+
+OutputQueue::~OutputQueue()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  task_added.notify_all();
+  if (worker.joinable())
+    worker.join();
+}
+
+
+
+void OutputQueue::set_max_pending(const unsigned int n)
+{
+  wait();
+  std::lock_guard<std::mutex> lock(mutex);
+  max_pending = supported_max_pending(n);
+}
+
+
+
+bool OutputQueue::is_asynchronous() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return max_pending > 0;
+}
+
+
+
+void OutputQueue::push(const std::function<void()> &task)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  rethrow_exception();
+
+  if (max_pending == 0)
+    {
+      lock.unlock();
+      task();
+      return;
+    }
+
+  task_done.wait(lock, [this] ()
+  {
+    return (tasks.size() + (busy ? 1 : 0) < max_pending) || exception;
+  });
+  rethrow_exception();
+
+  tasks.push_back(task);
+  if (!worker.joinable())
+    worker = std::thread(&OutputQueue::run, this);
+  lock.unlock();
+  task_added.notify_one();
+}
+
+
+
+void OutputQueue::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  task_done.wait(lock, [this] ()
+  {
+    return tasks.empty() && !busy;
+  });
+  rethrow_exception();
+}
+
+
+
+unsigned int OutputQueue::n_pending() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return tasks.size() + (busy ? 1 : 0);
+}
+
+
+
+void OutputQueue::run()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+    {
+      task_added.wait(lock, [this] ()
+      {
+        return stop || !tasks.empty();
+      });
+
+      // The remaining tasks are run before stopping
+      if (tasks.empty())
+        return;
+
+      std::function<void()> task = tasks.front();
+      tasks.pop_front();
+      busy = true;
+      lock.unlock();
+
+      std::exception_ptr task_exception;
+      try
+        {
+          task();
+        }
+      catch (...)
+        {
+          task_exception = std::current_exception();
+        }
+
+      lock.lock();
+      busy = false;
+      if (task_exception && !exception)
+        exception = task_exception;
+      task_done.notify_all();
+    }
+}
+
+
+
+void OutputQueue::rethrow_exception()
+{
+  if (exception)
+    {
+      std::exception_ptr e = exception;
+      exception = nullptr;
+      std::rethrow_exception(e);
+    }
+}
+
+D2K_NAMESPACE_CLOSE
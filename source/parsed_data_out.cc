@@ -14,6 +14,7 @@
 //-----------------------------------------------------------
 
 #include <deal2lkit/parsed_data_out.h>
+#include <deal2lkit/profiler.h>
 
 #include <deal.II/base/logstream.h>
 #include <deal.II/base/quadrature_lib.h>
@@ -165,6 +166,7 @@ void ParsedDataOut<dim,spacedim>::prepare_data_output(const DoFHandler<dim,space
 template <int dim, int spacedim>
 void ParsedDataOut<dim,spacedim>::write_data_and_clear( const Mapping<dim,spacedim> &mapping)
 {
+  D2K_INTERNAL_PROFILE_SCOPE("ParsedDataOut write data and clear");
   if (output_format=="none")
     return;
 
@@ -209,6 +211,16 @@ void ParsedDataOut<dim,spacedim>::write_data_and_clear( const Mapping<dim,spaced
 }
 
 
+template <int dim, int spacedim>
+std::size_t ParsedDataOut<dim,spacedim>::memory_consumption() const
+{
+  std::size_t bytes = sizeof(*this);
+  if (data_out)
+    bytes += data_out->memory_consumption();
+  return bytes;
+}
+
+
 D2K_NAMESPACE_CLOSE
 
 template class deal2lkit::ParsedDataOut<1,1>;
@@ -96,6 +96,17 @@ void ParsedKDTreeDistance<dim>::set_points(const std::vector<Point<dim> > &pts)
   kdtree->buildIndex();
 }
 
+template<int dim>
+std::size_t ParsedKDTreeDistance<dim>::memory_consumption() const
+{
+  std::size_t bytes = sizeof(*this);
+  if (kdtree)
+    bytes += sizeof(KDTree) + kdtree->usedMemory();
+  if (adaptor)
+    bytes += sizeof(PointCloudAdaptor);
+  return bytes;
+}
+
 
 template class ParsedKDTreeDistance<1>;
 template class ParsedKDTreeDistance<2>;
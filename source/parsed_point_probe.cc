@@ -0,0 +1,356 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#include <deal2lkit/parsed_point_probe.h>
+
+#include <deal.II/base/geometry_info.h>
+#include <deal.II/base/quadrature.h>
+#include <deal.II/fe/fe.h>
+#include <deal.II/fe/fe_values.h>
+#include <deal.II/fe/mapping_q1.h>
+#include <deal.II/grid/grid_tools.h>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+
+using namespace dealii;
+
+D2K_NAMESPACE_OPEN
+
+
+template<int dim, int spacedim>
+ParsedPointProbe<dim,spacedim>::ParsedPointProbe(const std::string &name,
+                                                 const std::vector<Point<spacedim> > &points,
+                                                 const unsigned int &n_candidate_cells,
+                                                 const unsigned int &max_leaf_size,
+                                                 const MPI_Comm &comm):
+  ParameterAcceptor(name),
+  points(points),
+  n_candidate_cells(n_candidate_cells),
+  max_leaf_size(max_leaf_size),
+  comm(comm),
+  located(false)
+{}
+
+
+
+template<int dim, int spacedim>
+ParsedPointProbe<dim,spacedim>::~ParsedPointProbe()
+{
+  tria_listener.disconnect();
+}
+
+
+
+template<int dim, int spacedim>
+void ParsedPointProbe<dim,spacedim>::declare_parameters(ParameterHandler &prm)
+{
+  add_parameter(prm, &points, "Probe points",
+                to_string(points), *to_pattern(points),
+                "Semicolon separated list of points where finite element "
+                "fields are evaluated. Coordinates of each point are "
+                "separated by commas.");
+
+  add_parameter(prm, &n_candidate_cells, "Number of candidate cells",
+                std::to_string(n_candidate_cells), Patterns::Integer(1),
+                "Number of cells, with the center closest to a probe point, that "
+                "are checked for containing the point before looking at the "
+                "cells around the closest vertex.");
+
+  add_parameter(prm, &max_leaf_size, "Max number of points per leaf",
+                std::to_string(max_leaf_size), Patterns::Integer(1),
+                "Max number of points per leaf in the kdtrees of cell centers "
+                "and vertices.");
+}
+
+
+
+template<int dim, int spacedim>
+void ParsedPointProbe<dim,spacedim>::parse_parameters_call_back()
+{
+  invalidate();
+}
+
+
+
+template<int dim, int spacedim>
+void ParsedPointProbe<dim,spacedim>::set_points(const std::vector<Point<spacedim> > &pts)
+{
+  points = pts;
+  invalidate();
+}
+
+
+
+template<int dim, int spacedim>
+const std::vector<Point<spacedim> > &
+ParsedPointProbe<dim,spacedim>::get_points() const
+{
+  return points;
+}
+
+
+
+template<int dim, int spacedim>
+void ParsedPointProbe<dim,spacedim>::invalidate()
+{
+  located = false;
+}
+
+
+
+template<int dim, int spacedim>
+bool ParsedPointProbe<dim,spacedim>::is_located() const
+{
+  return located;
+}
+
+
+
+template<int dim, int spacedim>
+bool ParsedPointProbe<dim,spacedim>::is_found(const unsigned int i) const
+{
+  Assert(located, ExcNotInitialized());
+  AssertIndexRange(i, found.size());
+  return found[i];
+}
+
+
+
+template<int dim, int spacedim>
+bool ParsedPointProbe<dim,spacedim>::is_locally_owned(const unsigned int i) const
+{
+  Assert(located, ExcNotInitialized());
+  AssertIndexRange(i, owned.size());
+  return owned[i];
+}
+
+
+
+template<int dim, int spacedim>
+void ParsedPointProbe<dim,spacedim>::get_candidate_cells(const Point<spacedim> &p,
+                                                         std::vector<unsigned int> &candidates) const
+{
+  candidates.clear();
+  if (cells.size() == 0)
+    return;
+
+  const unsigned int n_closest = std::min(n_candidate_cells,
+                                          (unsigned int)cells.size());
+  std::vector<unsigned int> indices(n_closest);
+  std::vector<double> distances(n_closest);
+  centers_tree->knnSearch(&p[0], n_closest, &indices[0], &distances[0]);
+  candidates = indices;
+
+  // A point close to a vertex may lie in a cell whose center is far
+  // away, e.g., on strongly graded meshes. Add all the cells sharing
+  // the closest vertex.
+  unsigned int vertex;
+  double vertex_distance;
+  vertices_tree->knnSearch(&p[0], 1, &vertex, &vertex_distance);
+  for (auto c : vertex_to_cells[vertex])
+    if (std::find(candidates.begin(), candidates.end(), c) == candidates.end())
+      candidates.push_back(c);
+}
+
+
+
+template<int dim, int spacedim>
+void ParsedPointProbe<dim,spacedim>::locate(const DoFHandler<dim,spacedim> &dh)
+{
+  locate(StaticMappingQ1<dim,spacedim>::mapping, dh);
+}
+
+
+
+template<int dim, int spacedim>
+void ParsedPointProbe<dim,spacedim>::locate(const Mapping<dim,spacedim> &map,
+                                            const DoFHandler<dim,spacedim> &dof)
+{
+  mapping = &map;
+  dh = &dof;
+
+  tria_listener.disconnect();
+  tria_listener = dof.get_triangulation().signals.any_change.connect
+                  (std::bind(&ParsedPointProbe<dim,spacedim>::invalidate, this));
+
+  // Index the locally owned cells and their vertices
+  cells.clear();
+  centers.clear();
+  vertices.clear();
+  vertex_to_cells.clear();
+
+  std::map<unsigned int, unsigned int> global_to_local_vertex;
+  double max_diameter = 0;
+
+  for (auto cell = dof.begin_active(); cell != dof.end(); ++cell)
+    if (cell->is_locally_owned())
+      {
+        const unsigned int c = cells.size();
+        cells.push_back(cell);
+        centers.push_back(cell->center());
+        max_diameter = std::max(max_diameter, cell->diameter());
+        for (unsigned int v=0; v<GeometryInfo<dim>::vertices_per_cell; ++v)
+          {
+            const unsigned int global_v = cell->vertex_index(v);
+            auto it = global_to_local_vertex.find(global_v);
+            if (it == global_to_local_vertex.end())
+              {
+                it = global_to_local_vertex.insert(std::make_pair(global_v,
+                                                                  (unsigned int)vertices.size())).first;
+                vertices.push_back(cell->vertex(v));
+                vertex_to_cells.push_back(std::vector<unsigned int>());
+              }
+            vertex_to_cells[it->second].push_back(c);
+          }
+      }
+
+  typedef typename ParsedKDTreeDistance<spacedim>::PointCloudAdaptor Adaptor;
+  typedef typename ParsedKDTreeDistance<spacedim>::KDTree KDTree;
+
+  if (cells.size() > 0)
+    {
+      centers_adaptor = SP(new Adaptor(centers));
+      centers_tree = SP(new KDTree(spacedim, *centers_adaptor,
+                                   nanoflann::KDTreeSingleIndexAdaptorParams(max_leaf_size)));
+      centers_tree->buildIndex();
+
+      vertices_adaptor = SP(new Adaptor(vertices));
+      vertices_tree = SP(new KDTree(spacedim, *vertices_adaptor,
+                                    nanoflann::KDTreeSingleIndexAdaptorParams(max_leaf_size)));
+      vertices_tree->buildIndex();
+    }
+
+  // Find the cell containing each probe
+  const unsigned int n_probes = points.size();
+  const unsigned int n_procs = Utilities::MPI::n_mpi_processes(comm);
+  const unsigned int this_proc = Utilities::MPI::this_mpi_process(comm);
+
+  std::vector<typename DoFHandler<dim,spacedim>::active_cell_iterator> probe_cells(n_probes);
+  reference_points.resize(n_probes);
+  std::vector<unsigned int> local_owner(n_probes, n_procs);
+  std::vector<unsigned int> candidates;
+
+  for (unsigned int i=0; i<n_probes; ++i)
+    {
+      const Point<spacedim> &p = points[i];
+      get_candidate_cells(p, candidates);
+
+      for (auto c : candidates)
+        {
+          try
+            {
+              const Point<dim> p_unit = map.transform_real_to_unit_cell(cells[c], p);
+              if (GeometryInfo<dim>::is_inside_unit_cell(p_unit, 1e-10))
+                {
+                  probe_cells[i] = cells[c];
+                  reference_points[i] = p_unit;
+                  local_owner[i] = this_proc;
+                  break;
+                }
+            }
+          catch (const typename Mapping<dim,spacedim>::ExcTransformationFailed &)
+            {}
+        }
+
+      // None of the candidates contains the point. If the point is
+      // not farther than the largest cell from the local mesh, fall
+      // back to the exhaustive search.
+      if (local_owner[i] == n_procs && cells.size() > 0)
+        {
+          unsigned int vertex;
+          double vertex_distance;
+          vertices_tree->knnSearch(&p[0], 1, &vertex, &vertex_distance);
+          if (p.distance(vertices[vertex]) <= max_diameter)
+            {
+              try
+                {
+                  const auto cell_and_point = GridTools::find_active_cell_around_point(map, dof, p);
+                  if (cell_and_point.first->is_locally_owned())
+                    {
+                      probe_cells[i] = cell_and_point.first;
+                      reference_points[i] = cell_and_point.second;
+                      local_owner[i] = this_proc;
+                    }
+                }
+              catch (...)
+                {}
+            }
+        }
+    }
+
+  // Assign each probe to the process with lowest rank that found it
+  std::vector<unsigned int> owner(n_probes);
+  Utilities::MPI::min(local_owner, comm, owner);
+
+  found.resize(n_probes);
+  owned.resize(n_probes);
+  for (unsigned int i=0; i<n_probes; ++i)
+    {
+      found[i] = (owner[i] < n_procs);
+      owned[i] = (owner[i] == this_proc);
+    }
+
+  // Cache dof indices and shape values, one FEValues per cell
+  const FiniteElement<dim,spacedim> &fe = dof.get_fe();
+  dof_indices.resize(n_probes);
+  shape_values.resize(n_probes);
+
+  std::map<typename DoFHandler<dim,spacedim>::active_cell_iterator,
+      std::vector<unsigned int> > probes_per_cell;
+  for (unsigned int i=0; i<n_probes; ++i)
+    if (owned[i])
+      probes_per_cell[probe_cells[i]].push_back(i);
+    else
+      {
+        dof_indices[i].clear();
+        shape_values[i].reinit(0,0);
+      }
+
+  for (auto &it : probes_per_cell)
+    {
+      const std::vector<unsigned int> &probes = it.second;
+      std::vector<Point<dim> > q_points(probes.size());
+      for (unsigned int q=0; q<probes.size(); ++q)
+        q_points[q] = reference_points[probes[q]];
+
+      Quadrature<dim> quadrature(q_points, std::vector<double>(probes.size(), 1.0));
+      FEValues<dim,spacedim> fe_values(map, fe, quadrature, update_values);
+      fe_values.reinit(it.first);
+
+      std::vector<types::global_dof_index> indices(fe.dofs_per_cell);
+      it.first->get_dof_indices(indices);
+
+      for (unsigned int q=0; q<probes.size(); ++q)
+        {
+          const unsigned int i = probes[q];
+          dof_indices[i] = indices;
+          shape_values[i].reinit(fe.dofs_per_cell, fe.n_components());
+          for (unsigned int j=0; j<fe.dofs_per_cell; ++j)
+            for (unsigned int c=0; c<fe.n_components(); ++c)
+              shape_values[i](j,c) = fe_values.shape_value_component(j,q,c);
+        }
+    }
+
+  located = true;
+}
+
+
+template class ParsedPointProbe<1,1>;
+template class ParsedPointProbe<2,2>;
+template class ParsedPointProbe<3,3>;
+
+D2K_NAMESPACE_CLOSE
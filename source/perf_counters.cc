@@ -0,0 +1,190 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#include <deal2lkit/perf_counters.h>
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+D2K_NAMESPACE_OPEN
+
+// protect the helper functions
+namespace
+{
+  const unsigned int n_groups = 2;
+
+#ifdef __linux__
+  /**
+   * Type, configuration and group of each event.
+   */
+  struct EventDescription
+  {
+    std::uint32_t type;
+    std::uint64_t config;
+    unsigned int group;
+  };
+
+  const EventDescription descriptions[PerfCounters::n_events] =
+  {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 0},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, 0},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS, 0},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, 0},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES, 1},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, 1},
+    {
+      PERF_TYPE_HW_CACHE,
+      PERF_COUNT_HW_CACHE_L1D |
+      (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), 1
+    }
+  };
+
+  /**
+   * Open a counter of the calling thread. The first event of a group
+   * is opened disabled, and enables the whole group later.
+   */
+  int open_event(const EventDescription &description,
+                 const int leader)
+  {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = description.type;
+    attr.config = description.config;
+    attr.disabled = (leader == -1);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP |
+                       PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+  }
+#endif
+}
+
+
+
+PerfCounters::PerfCounters() :
+  leaders(n_groups, -1)
+{
+  fds.fill(-1);
+  group.fill(0);
+  position.fill(0);
+
+#ifdef __linux__
+  std::vector<unsigned int> group_size(n_groups, 0);
+  for (unsigned int e=0; e<n_events; ++e)
+    {
+      const unsigned int g = descriptions[e].group;
+      fds[e] = open_event(descriptions[e], leaders[g]);
+      if (fds[e] == -1)
+        continue;
+
+      if (leaders[g] == -1)
+        leaders[g] = fds[e];
+      group[e] = g;
+      position[e] = group_size[g]++;
+    }
+
+  for (auto leader : leaders)
+    if (leader != -1)
+      {
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+      }
+#endif
+}
+
+
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+  for (auto fd : fds)
+    if (fd != -1)
+      close(fd);
+#endif
+}
+
+
+
+bool PerfCounters::is_available(const Event event) const
+{
+  return fds[event] != -1;
+}
+
+
+
+std::string PerfCounters::name(const Event event)
+{
+  static const char *names[n_events] =
+  {
+    "cycles",
+    "instructions",
+    "branches",
+    "branch misses",
+    "cache references",
+    "cache misses",
+    "L1D read misses"
+  };
+  return names[event];
+}
+
+
+
+PerfCounters::Values PerfCounters::read() const
+{
+  Values values;
+  values.fill(0.0);
+
+#ifdef __linux__
+  // Number of events, time enabled, time running, and the counts
+  std::uint64_t buffer[3+n_events];
+  double scaled[n_groups][n_events];
+  unsigned int n_scaled[n_groups] = {0, 0};
+
+  for (unsigned int g=0; g<n_groups; ++g)
+    {
+      if (leaders[g] == -1)
+        continue;
+      const ssize_t size = ::read(leaders[g], buffer, sizeof(buffer));
+      if (size < static_cast<ssize_t>(3*sizeof(std::uint64_t)))
+        continue;
+
+      // Correct for the time the group was not scheduled
+      const double scaling = (buffer[2] == 0 ? 0.0 :
+                              static_cast<double>(buffer[1])/buffer[2]);
+      for (unsigned int i=0; i<buffer[0] && i<n_events; ++i)
+        scaled[g][n_scaled[g]++] = scaling*buffer[3+i];
+    }
+
+  for (unsigned int e=0; e<n_events; ++e)
+    if (fds[e] != -1 && position[e] < n_scaled[group[e]])
+      values[e] = scaled[group[e]][position[e]];
+#endif
+
+  return values;
+}
+
+D2K_NAMESPACE_CLOSE
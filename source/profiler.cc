@@ -0,0 +1,736 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#include <deal2lkit/profiler.h>
+
+#include <deal.II/base/exceptions.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+using namespace dealii;
+
+D2K_NAMESPACE_OPEN
+
+namespace Profiler
+{
+  // protect the helper functions
+  namespace
+  {
+    const unsigned int invalid = static_cast<unsigned int>(-1);
+
+    /**
+     * A scope in the tree of the nested scopes of a thread.
+     */
+    struct Node
+    {
+      unsigned int site;
+      unsigned int parent;
+      unsigned long int n_calls;
+      std::int64_t time;
+      std::vector<unsigned int> children;
+      PerfCounters::Values counts;
+      double flops;
+    };
+
+    /**
+     * A timed interval, for the traces.
+     */
+    struct Event
+    {
+      unsigned int site;
+      std::int64_t start;
+      std::int64_t end;
+    };
+
+    /**
+     * Counters at the start of an open scope.
+     */
+    struct Sample
+    {
+      PerfCounters::Values counts;
+      double flops;
+    };
+
+    /**
+     * Data recorded by a single thread. Only the thread itself writes
+     * it.
+     */
+    struct ThreadData
+    {
+      ThreadData(const unsigned int index) :
+        index(index),
+        current(0),
+        nodes(1, Node {invalid, 0, 0, 0, {}, {}, 0}),
+        flops(0)
+      {}
+
+      const unsigned int index;
+
+      /** Node of the innermost open scope, zero if none. */
+      unsigned int current;
+
+      std::vector<Node> nodes;
+
+      std::vector<Event> events;
+
+      /** Hardware counters, opened by the thread itself. */
+      std::unique_ptr<PerfCounters> counters;
+
+      /** Floating point operations declared by the thread. */
+      double flops;
+
+      /** Counters at the start of the open scopes that read them. */
+      std::vector<Sample> samples;
+    };
+
+    /**
+     * Names of the sites and data of all the threads. The data of a
+     * thread is kept after the thread ends.
+     */
+    struct Registry
+    {
+      std::mutex mutex;
+      std::vector<std::string> names;
+      std::vector<std::unique_ptr<ThreadData> > threads;
+    };
+
+    Registry &get_registry()
+    {
+      static Registry registry;
+      return registry;
+    }
+
+    std::atomic<bool> enabled(false);
+    std::atomic<bool> record_trace(false);
+    std::atomic<unsigned int> max_trace_events(0);
+    std::atomic<bool> hardware_counters(false);
+
+    /**
+     * Bit mask of the events that could not be opened by some thread.
+     */
+    std::atomic<unsigned int> unavailable_events(0);
+
+    /**
+     * Nanoseconds since the first call.
+     */
+    std::int64_t now()
+    {
+      static const std::chrono::steady_clock::time_point origin =
+        std::chrono::steady_clock::now();
+      return std::chrono::duration_cast<std::chrono::nanoseconds>
+             (std::chrono::steady_clock::now() - origin).count();
+    }
+
+    ThreadData &get_thread_data()
+    {
+      thread_local ThreadData *data = nullptr;
+      if (data == nullptr)
+        {
+          Registry &registry = get_registry();
+          std::lock_guard<std::mutex> lock(registry.mutex);
+          registry.threads.emplace_back(new ThreadData(registry.threads.size()));
+          data = registry.threads.back().get();
+        }
+      return *data;
+    }
+
+    unsigned int register_name(const std::string &name)
+    {
+      Assert(name.find(';') == std::string::npos,
+             ExcMessage("The name of a scope cannot contain ';'."));
+      Registry &registry = get_registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      auto it = std::find(registry.names.begin(), registry.names.end(), name);
+      if (it != registry.names.end())
+        return it - registry.names.begin();
+      registry.names.push_back(name);
+      return registry.names.size()-1;
+    }
+
+    /**
+     * Order the paths so that the children of a scope follow it, i.e.,
+     * with ';' before any other character.
+     */
+    struct PathLess
+    {
+      bool operator()(const std::string &a, const std::string &b) const
+      {
+        return std::lexicographical_compare(a.begin(), a.end(),
+                                            b.begin(), b.end(),
+                                            [](const char x, const char y)
+        {
+          return (x == ';' ? '\0' : x) < (y == ';' ? '\0' : y);
+        });
+      }
+    };
+
+    struct Totals
+    {
+      Totals() : n_calls(0), time(0), self_time(0), flops(0)
+      {
+        counts.fill(0.0);
+      }
+
+      unsigned long int n_calls;
+      std::int64_t time;
+      std::int64_t self_time;
+      PerfCounters::Values counts;
+      double flops;
+    };
+
+    typedef std::map<std::string, Totals, PathLess> TotalsMap;
+
+    /**
+     * Totals of each path, summed over the threads of this process.
+     */
+    TotalsMap get_local_totals()
+    {
+      Registry &registry = get_registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+
+      TotalsMap totals;
+      for (const auto &thread : registry.threads)
+        {
+          const std::vector<Node> &nodes = thread->nodes;
+          std::vector<std::string> paths(nodes.size());
+          // Parents are always created before their children
+          for (unsigned int i=1; i<nodes.size(); ++i)
+            {
+              const std::string &name = registry.names[nodes[i].site];
+              paths[i] = (nodes[i].parent == 0 ? name : paths[nodes[i].parent] + ";" + name);
+
+              std::int64_t children_time = 0;
+              for (auto c : nodes[i].children)
+                children_time += nodes[c].time;
+
+              Totals &t = totals[paths[i]];
+              t.n_calls += nodes[i].n_calls;
+              t.time += nodes[i].time;
+              t.self_time += nodes[i].time - children_time;
+              for (unsigned int e=0; e<PerfCounters::n_events; ++e)
+                t.counts[e] += nodes[i].counts[e];
+              t.flops += nodes[i].flops;
+            }
+        }
+      return totals;
+    }
+
+    /**
+     * Gather @p local from all processes on the first one. Other
+     * processes get an empty vector.
+     */
+    std::vector<std::string> gather(const std::string &local,
+                                    const MPI_Comm comm)
+    {
+#ifdef DEAL_II_WITH_MPI
+      int initialized = 0;
+      MPI_Initialized(&initialized);
+      if (initialized)
+        {
+          int rank, n_procs;
+          MPI_Comm_rank(comm, &rank);
+          MPI_Comm_size(comm, &n_procs);
+
+          int size = local.size();
+          std::vector<int> sizes(n_procs);
+          MPI_Gather(&size, 1, MPI_INT, &sizes[0], 1, MPI_INT, 0, comm);
+
+          std::vector<int> offsets(n_procs, 0);
+          for (int i=1; i<n_procs; ++i)
+            offsets[i] = offsets[i-1] + sizes[i-1];
+
+          std::vector<char> buffer(rank == 0 ? offsets.back()+sizes.back()+1 : 1);
+          MPI_Gatherv(const_cast<char *>(local.data()), size, MPI_CHAR,
+                      &buffer[0], &sizes[0], &offsets[0], MPI_CHAR, 0, comm);
+
+          std::vector<std::string> all;
+          if (rank == 0)
+            for (int i=0; i<n_procs; ++i)
+              all.push_back(std::string(&buffer[offsets[i]], sizes[i]));
+          return all;
+        }
+#else
+      (void)comm;
+#endif
+      return std::vector<std::string>(1, local);
+    }
+
+    /**
+     * Parse the lines "path\tvalue\tvalue..." written by the processes.
+     */
+    std::vector<std::map<std::string, std::vector<double>, PathLess> >
+    parse(const std::vector<std::string> &all)
+    {
+      std::vector<std::map<std::string, std::vector<double>, PathLess> > result(all.size());
+      for (unsigned int p=0; p<all.size(); ++p)
+        {
+          std::istringstream in(all[p]);
+          std::string line;
+          while (std::getline(in, line))
+            {
+              std::istringstream fields(line);
+              std::string path;
+              std::getline(fields, path, '\t');
+              double value;
+              while (fields >> value)
+                result[p][path].push_back(value);
+            }
+        }
+      return result;
+    }
+
+    std::string escape_json(const std::string &s)
+    {
+      std::string escaped;
+      for (auto c : s)
+        {
+          if (c == '"' || c == '\\')
+            escaped += '\\';
+          escaped += c;
+        }
+      return escaped;
+    }
+  }
+
+
+
+  Site::Site(const std::string &name) :
+    id(register_name(name))
+  {}
+
+
+
+  Scope::Scope(const Site &site) :
+    node(invalid),
+    start(0),
+    counted(false)
+  {
+    if (!enabled.load(std::memory_order_relaxed))
+      return;
+
+    ThreadData &data = get_thread_data();
+    for (auto c : data.nodes[data.current].children)
+      if (data.nodes[c].site == site.id)
+        {
+          node = c;
+          break;
+        }
+
+    if (node == invalid)
+      {
+        node = data.nodes.size();
+        data.nodes.push_back(Node {site.id, data.current, 0, 0, {}, {}, 0});
+        data.nodes[data.current].children.push_back(node);
+      }
+
+    data.current = node;
+
+    counted = hardware_counters.load(std::memory_order_relaxed);
+    if (counted)
+      {
+        if (!data.counters)
+          {
+            data.counters.reset(new PerfCounters());
+            for (unsigned int e=0; e<PerfCounters::n_events; ++e)
+              if (!data.counters->is_available(PerfCounters::Event(e)))
+                unavailable_events |= (1u << e);
+          }
+        data.samples.push_back(Sample {data.counters->read(), data.flops});
+      }
+
+    start = now();
+  }
+
+
+
+  Scope::~Scope()
+  {
+    if (node == invalid)
+      return;
+
+    const std::int64_t end = now();
+    ThreadData &data = get_thread_data();
+
+    // The data was reset while the scope was open
+    if (node >= data.nodes.size())
+      return;
+
+    Node &n = data.nodes[node];
+    ++n.n_calls;
+    n.time += end - start;
+    data.current = n.parent;
+
+    if (record_trace.load(std::memory_order_relaxed) &&
+        data.events.size() < max_trace_events.load(std::memory_order_relaxed))
+      data.events.push_back(Event {n.site, start, end});
+
+    if (counted && !data.samples.empty())
+      {
+        const PerfCounters::Values counts = data.counters->read();
+        const Sample &sample = data.samples.back();
+        for (unsigned int e=0; e<PerfCounters::n_events; ++e)
+          n.counts[e] += counts[e] - sample.counts[e];
+        n.flops += data.flops - sample.flops;
+        data.samples.pop_back();
+      }
+  }
+
+
+
+  void enable(const bool trace,
+              const unsigned int max_events,
+              const bool counters)
+  {
+    now();
+    max_trace_events = max_events;
+    record_trace = trace;
+    hardware_counters = counters;
+    enabled = true;
+  }
+
+
+
+  void disable()
+  {
+    enabled = false;
+  }
+
+
+
+  bool is_enabled()
+  {
+    return enabled;
+  }
+
+
+
+  void reset()
+  {
+    Registry &registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto &thread : registry.threads)
+      {
+        thread->current = 0;
+        thread->nodes.resize(1);
+        thread->nodes[0].children.clear();
+        thread->events.clear();
+        thread->samples.clear();
+      }
+  }
+
+
+
+  unsigned long int n_calls(const std::string &path)
+  {
+    const TotalsMap totals = get_local_totals();
+    auto it = totals.find(path);
+    return (it == totals.end() ? 0 : it->second.n_calls);
+  }
+
+
+
+  double total_time(const std::string &path)
+  {
+    const TotalsMap totals = get_local_totals();
+    auto it = totals.find(path);
+    return (it == totals.end() ? 0 : 1e-9*it->second.time);
+  }
+
+
+
+  void add_flops(const double n_flops)
+  {
+    if (enabled.load(std::memory_order_relaxed) &&
+        hardware_counters.load(std::memory_order_relaxed))
+      get_thread_data().flops += n_flops;
+  }
+
+
+
+  double n_flops(const std::string &path)
+  {
+    const TotalsMap totals = get_local_totals();
+    auto it = totals.find(path);
+    return (it == totals.end() ? 0 : it->second.flops);
+  }
+
+
+
+  double hardware_counter(const std::string &path,
+                          const PerfCounters::Event event)
+  {
+    const TotalsMap totals = get_local_totals();
+    auto it = totals.find(path);
+    return (it == totals.end() ? 0 : it->second.counts[event]);
+  }
+
+
+
+  void print_summary(std::ostream &out,
+                     const MPI_Comm comm)
+  {
+    std::ostringstream local;
+    for (const auto &t : get_local_totals())
+      local << t.first << '\t' << t.second.n_calls << '\t' << t.second.time << '\n';
+
+    const auto all = parse(gather(local.str(), comm));
+    if (all.empty())
+      return;
+
+    // Paths that are missing on a process count as zero
+    std::map<std::string, std::vector<double>, PathLess> times;
+    std::map<std::string, double> calls;
+    for (unsigned int p=0; p<all.size(); ++p)
+      for (const auto &entry : all[p])
+        {
+          std::vector<double> &t = times[entry.first];
+          t.resize(all.size(), 0.0);
+          t[p] = 1e-9*entry.second[1];
+          calls[entry.first] += entry.second[0];
+        }
+
+    std::size_t width = 5;
+    for (const auto &entry : times)
+      {
+        const std::size_t depth = std::count(entry.first.begin(), entry.first.end(), ';');
+        const std::size_t name_start = entry.first.find_last_of(';');
+        const std::size_t name_length = entry.first.size() -
+                                        (name_start == std::string::npos ? 0 : name_start+1);
+        width = std::max(width, 2*depth + name_length);
+      }
+
+    const std::string line(width + 4*13, '-');
+    out << line << std::endl
+        << std::left << std::setw(width) << "Scope"
+        << std::right
+        << std::setw(13) << "Calls"
+        << std::setw(13) << "Min (s)"
+        << std::setw(13) << "Avg (s)"
+        << std::setw(13) << "Max (s)" << std::endl
+        << line << std::endl;
+
+    for (const auto &entry : times)
+      {
+        const std::size_t depth = std::count(entry.first.begin(), entry.first.end(), ';');
+        const std::size_t name_start = entry.first.find_last_of(';');
+        const std::string name = (name_start == std::string::npos ?
+                                  entry.first : entry.first.substr(name_start+1));
+        const std::vector<double> &t = entry.second;
+        double sum = 0;
+        for (auto v : t)
+          sum += v;
+
+        out << std::left << std::setw(width) << (std::string(2*depth, ' ') + name)
+            << std::right << std::setprecision(4)
+            << std::setw(13) << (unsigned long int)calls[entry.first]
+            << std::setw(13) << *std::min_element(t.begin(), t.end())
+            << std::setw(13) << sum/t.size()
+            << std::setw(13) << *std::max_element(t.begin(), t.end())
+            << std::endl;
+      }
+    out << line << std::endl;
+  }
+
+
+
+  void print_hardware_summary(std::ostream &out,
+                              const MPI_Comm comm)
+  {
+    // Each line has the time, the flops, and the counts, which are
+    // negative for the events that are not available
+    std::ostringstream local;
+    local << std::setprecision(17);
+    for (const auto &t : get_local_totals())
+      {
+        local << t.first << '\t' << t.second.time << '\t' << t.second.flops;
+        for (unsigned int e=0; e<PerfCounters::n_events; ++e)
+          local << '\t' << ((unavailable_events & (1u << e)) ? -1.0 : t.second.counts[e]);
+        local << '\n';
+      }
+
+    const auto all = parse(gather(local.str(), comm));
+    if (all.empty())
+      return;
+
+    // Maximum time, total flops, total counts, and availability
+    struct Metrics
+    {
+      Metrics() : time(0), flops(0)
+      {
+        counts.fill(0.0);
+        available.fill(true);
+      }
+      double time;
+      double flops;
+      PerfCounters::Values counts;
+      std::array<bool, PerfCounters::n_events> available;
+    };
+
+    std::map<std::string, Metrics, PathLess> metrics;
+    for (const auto &process : all)
+      for (const auto &entry : process)
+        {
+          Metrics &m = metrics[entry.first];
+          m.time = std::max(m.time, 1e-9*entry.second[0]);
+          m.flops += entry.second[1];
+          for (unsigned int e=0; e<PerfCounters::n_events; ++e)
+            {
+              const double count = entry.second[2+e];
+              if (count < 0)
+                m.available[e] = false;
+              else
+                m.counts[e] += count;
+            }
+        }
+
+    std::size_t width = 5;
+    for (const auto &entry : metrics)
+      {
+        const std::size_t depth = std::count(entry.first.begin(), entry.first.end(), ';');
+        const std::size_t name_start = entry.first.find_last_of(';');
+        const std::size_t name_length = entry.first.size() -
+                                        (name_start == std::string::npos ? 0 : name_start+1);
+        width = std::max(width, 2*depth + name_length);
+      }
+
+    const std::string line(width + 6*15, '-');
+    out << line << std::endl
+        << std::left << std::setw(width) << "Scope"
+        << std::right
+        << std::setw(15) << "Max (s)"
+        << std::setw(15) << "IPC"
+        << std::setw(15) << "L1D MPKI"
+        << std::setw(15) << "Cache miss %"
+        << std::setw(15) << "Branch miss %"
+        << std::setw(15) << "GFLOP/s" << std::endl
+        << line << std::endl;
+
+    for (const auto &entry : metrics)
+      {
+        const std::size_t depth = std::count(entry.first.begin(), entry.first.end(), ';');
+        const std::size_t name_start = entry.first.find_last_of(';');
+        const std::string name = (name_start == std::string::npos ?
+                                  entry.first : entry.first.substr(name_start+1));
+        const Metrics &m = entry.second;
+
+        // Ratio of two events, or "-" if it is not defined
+        auto ratio = [&m](const PerfCounters::Event a,
+                          const PerfCounters::Event b,
+                          const double scaling)
+        {
+          std::ostringstream s;
+          if (m.available[a] && m.available[b] && m.counts[b] > 0)
+            s << std::setprecision(4) << scaling*m.counts[a]/m.counts[b];
+          else
+            s << "-";
+          return s.str();
+        };
+
+        std::ostringstream gflops;
+        if (m.flops > 0 && m.time > 0)
+          gflops << std::setprecision(4) << 1e-9*m.flops/m.time;
+        else
+          gflops << "-";
+
+        out << std::left << std::setw(width) << (std::string(2*depth, ' ') + name)
+            << std::right << std::setprecision(4)
+            << std::setw(15) << m.time
+            << std::setw(15) << ratio(PerfCounters::instructions, PerfCounters::cycles, 1)
+            << std::setw(15) << ratio(PerfCounters::l1d_read_misses, PerfCounters::instructions, 1000)
+            << std::setw(15) << ratio(PerfCounters::cache_misses, PerfCounters::cache_references, 100)
+            << std::setw(15) << ratio(PerfCounters::branch_misses, PerfCounters::branches, 100)
+            << std::setw(15) << gflops.str()
+            << std::endl;
+      }
+    out << line << std::endl;
+  }
+
+
+
+  void write_flame_graph(std::ostream &out,
+                         const MPI_Comm comm)
+  {
+    std::ostringstream local;
+    for (const auto &t : get_local_totals())
+      local << t.first << '\t' << t.second.self_time << '\n';
+
+    const auto all = parse(gather(local.str(), comm));
+
+    std::map<std::string, double, PathLess> self_times;
+    for (const auto &process : all)
+      for (const auto &entry : process)
+        self_times[entry.first] += entry.second[0];
+
+    for (const auto &entry : self_times)
+      {
+        const unsigned long int microseconds = entry.second/1000;
+        if (microseconds > 0)
+          out << entry.first << ' ' << microseconds << '\n';
+      }
+    out << std::flush;
+  }
+
+
+
+  void write_chrome_trace(std::ostream &out,
+                          const MPI_Comm comm)
+  {
+    unsigned int rank = 0;
+#ifdef DEAL_II_WITH_MPI
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if (initialized)
+      rank = Utilities::MPI::this_mpi_process(comm);
+#endif
+
+    std::ostringstream local;
+    local << std::fixed << std::setprecision(3);
+    {
+      Registry &registry = get_registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      for (const auto &thread : registry.threads)
+        for (const auto &event : thread->events)
+          local << "{\"name\":\"" << escape_json(registry.names[event.site])
+                << "\",\"ph\":\"X\",\"pid\":" << rank
+                << ",\"tid\":" << thread->index
+                << ",\"ts\":" << 1e-3*event.start
+                << ",\"dur\":" << 1e-3*(event.end - event.start)
+                << "},\n";
+    }
+
+    const std::vector<std::string> all = gather(local.str(), comm);
+    if (all.empty())
+      return;
+
+    std::string events;
+    for (const auto &process : all)
+      events += process;
+    // Remove the last separator
+    if (events.size() >= 2)
+      events.resize(events.size()-2);
+
+    out << "{\"traceEvents\":[\n" << events << "\n],"
+        << "\"displayTimeUnit\":\"ms\"}" << std::endl;
+  }
+}
+
+D2K_NAMESPACE_CLOSE
@@ -0,0 +1,685 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#include <deal2lkit/sundials_nvector.h>
+
+#ifdef D2K_WITH_SUNDIALS
+
+#include <deal.II/lac/block_vector.h>
+#ifdef DEAL_II_WITH_TRILINOS
+#include <deal.II/lac/trilinos_block_vector.h>
+#include <deal.II/lac/trilinos_parallel_block_vector.h>
+#include <deal.II/lac/trilinos_vector.h>
+#endif
+#ifdef DEAL_II_WITH_PETSC
+#include <deal.II/lac/petsc_block_vector.h>
+#include <deal.II/lac/petsc_parallel_block_vector.h>
+#include <deal.II/lac/petsc_vector.h>
+#endif
+
+#include <sundials/sundials_math.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+using namespace dealii;
+
+D2K_NAMESPACE_OPEN
+
+namespace NVectorWrappers
+{
+  // protect the helper functions
+  namespace
+  {
+    /**
+     * Serial vectors are replicated on all processes, and no
+     * reduction is needed.
+     */
+    template<typename VEC>
+    struct IsSerial
+    {
+      static const bool value = false;
+    };
+
+    template<>
+    struct IsSerial<BlockVector<double> >
+    {
+      static const bool value = true;
+    };
+
+
+    template<typename VEC>
+    inline Content<VEC> *content(N_Vector v)
+    {
+      return static_cast<Content<VEC> *>(v->content);
+    }
+
+
+    /**
+     * Blocks of a vector. Vectors that are not block vectors are made
+     * of a single block, themselves.
+     */
+    template<typename VEC>
+    struct Blocks
+    {
+      typedef VEC BlockType;
+
+      static unsigned int n(const VEC &)
+      {
+        return 1;
+      }
+
+      static BlockType &get(VEC &v, const unsigned int)
+      {
+        return v;
+      }
+    };
+
+    template<typename VEC, typename BLOCK>
+    struct BlockVectorBlocks
+    {
+      typedef BLOCK BlockType;
+
+      static unsigned int n(const VEC &v)
+      {
+        return v.n_blocks();
+      }
+
+      static BlockType &get(VEC &v, const unsigned int b)
+      {
+        return v.block(b);
+      }
+    };
+
+    template<>
+    struct Blocks<BlockVector<double> > :
+      public BlockVectorBlocks<BlockVector<double>, Vector<double> >
+    {};
+
+#ifdef DEAL_II_WITH_MPI
+#ifdef DEAL_II_WITH_TRILINOS
+    template<>
+    struct Blocks<TrilinosWrappers::MPI::BlockVector> :
+      public BlockVectorBlocks<TrilinosWrappers::MPI::BlockVector,
+      TrilinosWrappers::MPI::Vector>
+    {};
+#endif
+
+#ifdef DEAL_II_WITH_PETSC
+    template<>
+    struct Blocks<PETScWrappers::MPI::BlockVector> :
+      public BlockVectorBlocks<PETScWrappers::MPI::BlockVector,
+      PETScWrappers::MPI::Vector>
+    {};
+#endif
+#endif
+
+
+    /**
+     * The locally owned elements of a vector that is not a block
+     * vector, which are stored in a single array, ordered as the
+     * locally owned index set. They can be read and written directly,
+     * without compress().
+     *
+     * If @p alias refers to the same vector, its array is used, so
+     * that each vector is accessed only once at a time.
+     */
+    template<typename V>
+    struct LocalArray
+    {
+      LocalArray(V &v, const LocalArray<V> *alias = nullptr) :
+        data(v.begin()),
+        size(v.end() - v.begin())
+      {
+        (void) alias;
+      }
+
+      double *data;
+      std::size_t size;
+    };
+
+#ifdef DEAL_II_WITH_MPI
+#ifdef DEAL_II_WITH_PETSC
+    template<>
+    struct LocalArray<PETScWrappers::MPI::Vector>
+    {
+      LocalArray(PETScWrappers::MPI::Vector &v,
+                 const LocalArray<PETScWrappers::MPI::Vector> *alias = nullptr) :
+        vec(static_cast<const Vec &>(v)),
+        size(v.local_size()),
+        owner(alias == nullptr || alias->vec != vec)
+      {
+        if (owner)
+          {
+            const PetscErrorCode ierr = VecGetArray(vec, &data);
+            AssertThrow(ierr == 0, ExcPETScError(ierr));
+          }
+        else
+          data = alias->data;
+      }
+
+      ~LocalArray()
+      {
+        if (owner)
+          VecRestoreArray(vec, &data);
+      }
+
+      Vec vec;
+      double *data;
+      std::size_t size;
+      bool owner;
+    };
+#endif
+#endif
+
+
+    /**
+     * Call @p operation(a, b, c, size) on the local arrays of each
+     * block of the vectors @p na, @p nb and @p nc, which may be the
+     * same vector.
+     */
+    template<typename VEC, typename Operation>
+    void for_each_local_block(const Operation &operation,
+                              N_Vector na, N_Vector nb, N_Vector nc)
+    {
+      typedef typename Blocks<VEC>::BlockType BlockType;
+
+      VEC &a = get<VEC>(na);
+      VEC &b = get<VEC>(nb);
+      VEC &c = get<VEC>(nc);
+
+      for (unsigned int i=0; i<Blocks<VEC>::n(a); ++i)
+        {
+          LocalArray<BlockType> local_a(Blocks<VEC>::get(a, i));
+          LocalArray<BlockType> local_b(Blocks<VEC>::get(b, i), &local_a);
+          LocalArray<BlockType> local_c(Blocks<VEC>::get(c, i),
+                                        &c == &a ? &local_a : &local_b);
+          Assert(local_b.size == local_a.size && local_c.size == local_a.size,
+                 ExcDimensionMismatch(local_b.size, local_a.size));
+          operation(local_a.data, local_b.data, local_c.data, local_a.size);
+        }
+    }
+
+
+    template<typename VEC>
+    inline double reduce_sum(N_Vector v, const double local)
+    {
+      if (IsSerial<VEC>::value)
+        return local;
+      return Utilities::MPI::sum(local, content<VEC>(v)->comm);
+    }
+
+
+    template<typename VEC>
+    inline double reduce_min(N_Vector v, const double local)
+    {
+      if (IsSerial<VEC>::value)
+        return local;
+      return Utilities::MPI::min(local, content<VEC>(v)->comm);
+    }
+
+
+    template<typename VEC>
+    N_Vector clone_empty(N_Vector w)
+    {
+      N_Vector v = (N_Vector) malloc(sizeof *v);
+      AssertThrow(v != nullptr, ExcOutOfMemory());
+
+      v->ops = (N_Vector_Ops) malloc(sizeof *(v->ops));
+      AssertThrow(v->ops != nullptr, ExcOutOfMemory());
+      *(v->ops) = *(w->ops);
+
+      Content<VEC> *c = new Content<VEC>;
+      c->vector = nullptr;
+      c->owns_vector = false;
+      c->locally_owned = content<VEC>(w)->locally_owned;
+      c->comm = content<VEC>(w)->comm;
+      v->content = c;
+
+      return v;
+    }
+
+
+    template<typename VEC>
+    N_Vector clone(N_Vector w)
+    {
+      N_Vector v = clone_empty<VEC>(w);
+      Content<VEC> *c = content<VEC>(v);
+      c->vector = new VEC();
+      c->vector->reinit(get<VEC>(w));
+      c->owns_vector = true;
+      return v;
+    }
+
+
+    template<typename VEC>
+    void destroy(N_Vector v)
+    {
+      if (v == nullptr)
+        return;
+      Content<VEC> *c = content<VEC>(v);
+      if (c != nullptr)
+        {
+          if (c->owns_vector)
+            delete c->vector;
+          delete c;
+        }
+      free(v->ops);
+      free(v);
+    }
+
+
+    template<typename VEC>
+    void space(N_Vector v, long int *lrw, long int *liw)
+    {
+      *lrw = content<VEC>(v)->locally_owned.n_elements();
+      *liw = 2;
+    }
+
+
+    template<typename VEC>
+    realtype *get_array_pointer(N_Vector)
+    {
+      // The storage of a deal.II vector is not necessarily contiguous
+      return nullptr;
+    }
+
+
+    template<typename VEC>
+    void set_array_pointer(realtype *, N_Vector)
+    {
+      AssertThrow(false, ExcNotImplemented());
+    }
+
+
+    template<typename VEC>
+    void linear_sum(realtype a, N_Vector nx, realtype b, N_Vector ny, N_Vector nz)
+    {
+      VEC &x = get<VEC>(nx);
+      VEC &y = get<VEC>(ny);
+      VEC &z = get<VEC>(nz);
+
+      if (&z == &x && &z == &y)
+        z *= (a+b);
+      else if (&z == &x)
+        z.sadd(a, b, y);
+      else if (&z == &y)
+        z.sadd(b, a, x);
+      else
+        {
+          z.equ(a, x);
+          z.add(b, y);
+        }
+    }
+
+
+    template<typename VEC>
+    void set_const(realtype c, N_Vector nz)
+    {
+      get<VEC>(nz) = c;
+    }
+
+
+    template<typename VEC>
+    void prod(N_Vector nx, N_Vector ny, N_Vector nz)
+    {
+      VEC &x = get<VEC>(nx);
+      VEC &y = get<VEC>(ny);
+      VEC &z = get<VEC>(nz);
+
+      if (&z == &y)
+        z.scale(x);
+      else
+        {
+          if (&z != &x)
+            z = x;
+          z.scale(y);
+        }
+    }
+
+
+    template<typename VEC>
+    void div(N_Vector nx, N_Vector ny, N_Vector nz)
+    {
+      for_each_local_block<VEC>([](const double *x, const double *y,
+                                   double *z, const std::size_t n)
+      {
+        for (std::size_t i=0; i<n; ++i)
+          z[i] = x[i]/y[i];
+      }, nx, ny, nz);
+    }
+
+
+    template<typename VEC>
+    void scale(realtype c, N_Vector nx, N_Vector nz)
+    {
+      VEC &x = get<VEC>(nx);
+      VEC &z = get<VEC>(nz);
+
+      if (&z == &x)
+        z *= c;
+      else
+        z.equ(c, x);
+    }
+
+
+    template<typename VEC>
+    void abs(N_Vector nx, N_Vector nz)
+    {
+      for_each_local_block<VEC>([](const double *x, const double *,
+                                   double *z, const std::size_t n)
+      {
+        for (std::size_t i=0; i<n; ++i)
+          z[i] = std::abs(x[i]);
+      }, nx, nx, nz);
+    }
+
+
+    template<typename VEC>
+    void inv(N_Vector nx, N_Vector nz)
+    {
+      for_each_local_block<VEC>([](const double *x, const double *,
+                                   double *z, const std::size_t n)
+      {
+        for (std::size_t i=0; i<n; ++i)
+          z[i] = 1.0/x[i];
+      }, nx, nx, nz);
+    }
+
+
+    template<typename VEC>
+    void add_const(N_Vector nx, realtype b, N_Vector nz)
+    {
+      for_each_local_block<VEC>([b](const double *x, const double *,
+                                    double *z, const std::size_t n)
+      {
+        for (std::size_t i=0; i<n; ++i)
+          z[i] = x[i] + b;
+      }, nx, nx, nz);
+    }
+
+
+    template<typename VEC>
+    realtype dot_prod(N_Vector nx, N_Vector ny)
+    {
+      return get<VEC>(nx) * get<VEC>(ny);
+    }
+
+
+    template<typename VEC>
+    realtype max_norm(N_Vector nx)
+    {
+      return get<VEC>(nx).linfty_norm();
+    }
+
+
+    template<typename VEC>
+    realtype wrms_norm(N_Vector nx, N_Vector nw)
+    {
+      double sum = 0;
+      for_each_local_block<VEC>([&sum](const double *x, const double *w,
+                                       const double *, const std::size_t n)
+      {
+        for (std::size_t i=0; i<n; ++i)
+          sum += (x[i]*w[i])*(x[i]*w[i]);
+      }, nx, nw, nx);
+      return std::sqrt(reduce_sum<VEC>(nx, sum)/get<VEC>(nx).size());
+    }
+
+
+    template<typename VEC>
+    realtype wrms_norm_mask(N_Vector nx, N_Vector nw, N_Vector nid)
+    {
+      double sum = 0;
+      for_each_local_block<VEC>([&sum](const double *x, const double *w,
+                                       const double *id, const std::size_t n)
+      {
+        for (std::size_t i=0; i<n; ++i)
+          if (id[i] > 0.0)
+            sum += (x[i]*w[i])*(x[i]*w[i]);
+      }, nx, nw, nid);
+      return std::sqrt(reduce_sum<VEC>(nx, sum)/get<VEC>(nx).size());
+    }
+
+
+    template<typename VEC>
+    realtype min(N_Vector nx)
+    {
+      double local_min = std::numeric_limits<double>::max();
+      for_each_local_block<VEC>([&local_min](const double *x, const double *,
+                                             const double *, const std::size_t n)
+      {
+        for (std::size_t i=0; i<n; ++i)
+          local_min = std::min(local_min, x[i]);
+      }, nx, nx, nx);
+      return reduce_min<VEC>(nx, local_min);
+    }
+
+
+    template<typename VEC>
+    realtype wl2_norm(N_Vector nx, N_Vector nw)
+    {
+      double sum = 0;
+      for_each_local_block<VEC>([&sum](const double *x, const double *w,
+                                       const double *, const std::size_t n)
+      {
+        for (std::size_t i=0; i<n; ++i)
+          sum += (x[i]*w[i])*(x[i]*w[i]);
+      }, nx, nw, nx);
+      return std::sqrt(reduce_sum<VEC>(nx, sum));
+    }
+
+
+    template<typename VEC>
+    realtype l1_norm(N_Vector nx)
+    {
+      return get<VEC>(nx).l1_norm();
+    }
+
+
+    template<typename VEC>
+    void compare(realtype c, N_Vector nx, N_Vector nz)
+    {
+      for_each_local_block<VEC>([c](const double *x, const double *,
+                                    double *z, const std::size_t n)
+      {
+        for (std::size_t i=0; i<n; ++i)
+          z[i] = (std::abs(x[i]) >= c) ? 1.0 : 0.0;
+      }, nx, nx, nz);
+    }
+
+
+    template<typename VEC>
+    booleantype inv_test(N_Vector nx, N_Vector nz)
+    {
+      double no_zero = 1.0;
+      for_each_local_block<VEC>([&no_zero](const double *x, const double *,
+                                           double *z, const std::size_t n)
+      {
+        for (std::size_t i=0; i<n; ++i)
+          {
+            if (x[i] == 0.0)
+              no_zero = 0.0;
+            else
+              z[i] = 1.0/x[i];
+          }
+      }, nx, nx, nz);
+      return (reduce_min<VEC>(nx, no_zero) == 1.0);
+    }
+
+
+    template<typename VEC>
+    booleantype constr_mask(N_Vector nc, N_Vector nx, N_Vector nm)
+    {
+      double all_passed = 1.0;
+      for_each_local_block<VEC>([&all_passed](const double *c, const double *x,
+                                              double *m, const std::size_t n)
+      {
+        for (std::size_t i=0; i<n; ++i)
+          {
+            bool violated = false;
+            if (c[i] == 2.0)
+              violated = (x[i] <= 0.0);
+            else if (c[i] == 1.0)
+              violated = (x[i] < 0.0);
+            else if (c[i] == -1.0)
+              violated = (x[i] > 0.0);
+            else if (c[i] == -2.0)
+              violated = (x[i] >= 0.0);
+
+            m[i] = violated ? 1.0 : 0.0;
+            if (violated)
+              all_passed = 0.0;
+          }
+      }, nc, nx, nm);
+      return (reduce_min<VEC>(nm, all_passed) == 1.0);
+    }
+
+
+    template<typename VEC>
+    realtype min_quotient(N_Vector nnum, N_Vector ndenom)
+    {
+      double local_min = BIG_REAL;
+      for_each_local_block<VEC>([&local_min](const double *num, const double *denom,
+                                             const double *, const std::size_t n)
+      {
+        for (std::size_t i=0; i<n; ++i)
+          if (denom[i] != 0.0)
+            local_min = std::min(local_min, num[i]/denom[i]);
+      }, nnum, ndenom, nnum);
+      return reduce_min<VEC>(nnum, local_min);
+    }
+
+
+    template<typename VEC>
+    N_Vector create_empty(VEC &vector, const MPI_Comm comm)
+    {
+      N_Vector v = (N_Vector) malloc(sizeof *v);
+      AssertThrow(v != nullptr, ExcOutOfMemory());
+
+      v->ops = (N_Vector_Ops) calloc(1, sizeof *(v->ops));
+      AssertThrow(v->ops != nullptr, ExcOutOfMemory());
+
+#ifdef SUNDIALS_VERSION
+      v->ops->nvgetvectorid     = [](N_Vector) -> N_Vector_ID
+      {
+        return SUNDIALS_NVEC_CUSTOM;
+      };
+#endif
+      v->ops->nvclone           = clone<VEC>;
+      v->ops->nvcloneempty      = clone_empty<VEC>;
+      v->ops->nvdestroy         = destroy<VEC>;
+      v->ops->nvspace           = space<VEC>;
+      v->ops->nvgetarraypointer = get_array_pointer<VEC>;
+      v->ops->nvsetarraypointer = set_array_pointer<VEC>;
+      v->ops->nvlinearsum       = linear_sum<VEC>;
+      v->ops->nvconst           = set_const<VEC>;
+      v->ops->nvprod            = prod<VEC>;
+      v->ops->nvdiv             = div<VEC>;
+      v->ops->nvscale           = scale<VEC>;
+      v->ops->nvabs             = abs<VEC>;
+      v->ops->nvinv             = inv<VEC>;
+      v->ops->nvaddconst        = add_const<VEC>;
+      v->ops->nvdotprod         = dot_prod<VEC>;
+      v->ops->nvmaxnorm         = max_norm<VEC>;
+      v->ops->nvwrmsnorm        = wrms_norm<VEC>;
+      v->ops->nvwrmsnormmask    = wrms_norm_mask<VEC>;
+      v->ops->nvmin             = min<VEC>;
+      v->ops->nvwl2norm         = wl2_norm<VEC>;
+      v->ops->nvl1norm          = l1_norm<VEC>;
+      v->ops->nvcompare         = compare<VEC>;
+      v->ops->nvinvtest         = inv_test<VEC>;
+      v->ops->nvconstrmask      = constr_mask<VEC>;
+      v->ops->nvminquotient     = min_quotient<VEC>;
+
+      Content<VEC> *c = new Content<VEC>;
+      c->vector = nullptr;
+      c->owns_vector = false;
+      c->locally_owned = vector.locally_owned_elements();
+      c->comm = comm;
+      v->content = c;
+
+      return v;
+    }
+  }
+
+
+
+  template<typename VEC>
+  N_Vector create_view(VEC &vector, const MPI_Comm comm)
+  {
+    N_Vector v = create_empty(vector, comm);
+    content<VEC>(v)->vector = &vector;
+    return v;
+  }
+
+
+
+  template<typename VEC>
+  N_Vector create_copy(const VEC &vector, const MPI_Comm comm)
+  {
+    VEC *copy = new VEC(vector);
+    N_Vector v = create_empty(*copy, comm);
+    content<VEC>(v)->vector = copy;
+    content<VEC>(v)->owns_vector = true;
+    return v;
+  }
+
+
+
+  template<typename VEC>
+  void reinit(N_Vector v, const VEC &vector)
+  {
+    Content<VEC> *c = content<VEC>(v);
+    if (c->owns_vector)
+      {
+        c->vector->reinit(vector, true);
+        *(c->vector) = vector;
+      }
+    else
+      c->vector = const_cast<VEC *>(&vector);
+    c->locally_owned = vector.locally_owned_elements();
+  }
+
+
+
+#define INSTANTIATE(VEC) \
+  template N_Vector create_view<VEC>(VEC &, const MPI_Comm); \
+  template N_Vector create_copy<VEC>(const VEC &, const MPI_Comm); \
+  template void reinit<VEC>(N_Vector, const VEC &);
+
+  INSTANTIATE(BlockVector<double>)
+
+#ifdef DEAL_II_WITH_MPI
+
+#ifdef DEAL_II_WITH_TRILINOS
+  INSTANTIATE(TrilinosWrappers::MPI::Vector)
+  INSTANTIATE(TrilinosWrappers::MPI::BlockVector)
+#endif
+
+#ifdef DEAL_II_WITH_PETSC
+  INSTANTIATE(PETScWrappers::MPI::Vector)
+  INSTANTIATE(PETScWrappers::MPI::BlockVector)
+#endif
+
+#endif
+
+#undef INSTANTIATE
+}
+
+D2K_NAMESPACE_CLOSE
+
+#endif
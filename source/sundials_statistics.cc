@@ -0,0 +1,307 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#include <deal2lkit/sundials_statistics.h>
+
+#include <deal.II/base/exceptions.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+using namespace dealii;
+
+D2K_NAMESPACE_OPEN
+
+// protect the helper functions
+namespace
+{
+  /**
+   * Counters are stored as doubles in the entries: print them as
+   * integers.
+   */
+  std::string format_value(const double value)
+  {
+    std::ostringstream s;
+    if (value == std::floor(value) && std::abs(value) < 1e15)
+      s << (long long int)value;
+    else
+      s << value;
+    return s.str();
+  }
+}
+
+
+
+CallbackStatistics::CallbackStatistics() :
+  n_calls(0),
+  wall_time(0)
+{}
+
+
+
+CallbackStatistics
+CallbackStatistics::operator-(const CallbackStatistics &other) const
+{
+  CallbackStatistics ret;
+  ret.n_calls = n_calls - other.n_calls;
+  ret.wall_time = wall_time - other.wall_time;
+  return ret;
+}
+
+
+
+CallbackStatistics
+CallbackStatistics::operator+(const CallbackStatistics &other) const
+{
+  CallbackStatistics ret;
+  ret.n_calls = n_calls + other.n_calls;
+  ret.wall_time = wall_time + other.wall_time;
+  return ret;
+}
+
+
+
+CallbackScope::CallbackScope(CallbackStatistics &stats) :
+  stats(stats),
+  start(std::chrono::steady_clock::now())
+{}
+
+
+
+CallbackScope::~CallbackScope()
+{
+  const std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+  ++stats.n_calls;
+  stats.wall_time += elapsed.count();
+}
+
+
+
+SolverStatistics::~SolverStatistics()
+{}
+
+
+
+void SolverStatistics::print_table(std::ostream &out,
+                                   const std::string &title) const
+{
+  std::vector<std::pair<std::string, double> > entries;
+  get_entries(entries);
+
+  std::size_t width = title.size();
+  for (auto &e : entries)
+    width = std::max(width, e.first.size());
+  width += 2;
+
+  const std::ios::fmtflags flags = out.flags();
+
+  const std::string line(width+16, '-');
+  out << line << std::endl;
+  if (title != "")
+    out << title << std::endl
+        << line << std::endl;
+  for (auto &e : entries)
+    out << std::left << std::setw(width) << e.first
+        << std::right << std::setw(16) << format_value(e.second)
+        << std::endl;
+  out << line << std::endl;
+
+  out.flags(flags);
+}
+
+
+
+void SolverStatistics::print_json(std::ostream &out) const
+{
+  std::vector<std::pair<std::string, double> > entries;
+  get_entries(entries);
+
+  out << "{";
+  for (unsigned int i=0; i<entries.size(); ++i)
+    out << (i == 0 ? "" : ", ")
+        << "\"" << entries[i].first << "\": " << format_value(entries[i].second);
+  out << "}" << std::endl;
+}
+
+
+
+void SolverStatistics::print(std::ostream &out,
+                             const std::string &format,
+                             const std::string &title) const
+{
+  if (format == "table")
+    print_table(out, title);
+  else if (format == "json")
+    print_json(out);
+  else
+    AssertThrow(format == "none",
+                ExcMessage("Unknown statistics format: " + format));
+}
+
+
+
+void SolverStatistics::add_entries(std::vector<std::pair<std::string, double> > &entries,
+                                   const std::string &name,
+                                   const CallbackStatistics &stats)
+{
+  entries.push_back(std::make_pair(name + "_calls", (double)stats.n_calls));
+  entries.push_back(std::make_pair(name + "_wall_time", stats.wall_time));
+}
+
+
+
+IDAStatistics::IDAStatistics() :
+  n_steps(0),
+  n_residual_evaluations(0),
+  n_jacobian_setups(0),
+  n_nonlinear_iterations(0),
+  n_nonlinear_convergence_failures(0),
+  n_error_test_failures(0),
+  n_linear_iterations(0),
+  n_restarts(0),
+  n_events(0),
+  last_order(0),
+  last_step_size(0),
+  current_step_size(0),
+  current_time(0)
+{}
+
+
+
+IDAStatistics IDAStatistics::operator-(const IDAStatistics &previous) const
+{
+  IDAStatistics ret(*this);
+  ret.n_steps -= previous.n_steps;
+  ret.n_residual_evaluations -= previous.n_residual_evaluations;
+  ret.n_jacobian_setups -= previous.n_jacobian_setups;
+  ret.n_nonlinear_iterations -= previous.n_nonlinear_iterations;
+  ret.n_nonlinear_convergence_failures -= previous.n_nonlinear_convergence_failures;
+  ret.n_error_test_failures -= previous.n_error_test_failures;
+  ret.n_linear_iterations -= previous.n_linear_iterations;
+  ret.n_restarts -= previous.n_restarts;
+  ret.n_events -= previous.n_events;
+  ret.residual = residual - previous.residual;
+  ret.setup_jacobian = setup_jacobian - previous.setup_jacobian;
+  ret.solve_jacobian_system = solve_jacobian_system - previous.solve_jacobian_system;
+  ret.jacobian_vmult = jacobian_vmult - previous.jacobian_vmult;
+  ret.setup_preconditioner = setup_preconditioner - previous.setup_preconditioner;
+  ret.solve_preconditioner = solve_preconditioner - previous.solve_preconditioner;
+  ret.event_function = event_function - previous.event_function;
+  ret.output_step = output_step - previous.output_step;
+  return ret;
+}
+
+
+
+void IDAStatistics::get_entries(std::vector<std::pair<std::string, double> > &entries) const
+{
+  entries.clear();
+  entries.push_back(std::make_pair("current_time", current_time));
+  entries.push_back(std::make_pair("n_steps", (double)n_steps));
+  entries.push_back(std::make_pair("n_residual_evaluations", (double)n_residual_evaluations));
+  entries.push_back(std::make_pair("n_jacobian_setups", (double)n_jacobian_setups));
+  entries.push_back(std::make_pair("n_nonlinear_iterations", (double)n_nonlinear_iterations));
+  entries.push_back(std::make_pair("n_nonlinear_convergence_failures", (double)n_nonlinear_convergence_failures));
+  entries.push_back(std::make_pair("n_error_test_failures", (double)n_error_test_failures));
+  entries.push_back(std::make_pair("n_linear_iterations", (double)n_linear_iterations));
+  entries.push_back(std::make_pair("n_restarts", (double)n_restarts));
+  entries.push_back(std::make_pair("n_events", (double)n_events));
+  entries.push_back(std::make_pair("last_order", (double)last_order));
+  entries.push_back(std::make_pair("last_step_size", last_step_size));
+  entries.push_back(std::make_pair("current_step_size", current_step_size));
+  add_entries(entries, "residual", residual);
+  add_entries(entries, "setup_jacobian", setup_jacobian);
+  add_entries(entries, "solve_jacobian_system", solve_jacobian_system);
+  add_entries(entries, "jacobian_vmult", jacobian_vmult);
+  add_entries(entries, "setup_preconditioner", setup_preconditioner);
+  add_entries(entries, "solve_preconditioner", solve_preconditioner);
+  add_entries(entries, "event_function", event_function);
+  add_entries(entries, "output_step", output_step);
+}
+
+
+
+KINSOLStatistics::KINSOLStatistics() :
+  n_nonlinear_iterations(0),
+  n_residual_evaluations(0),
+  n_beta_condition_failures(0),
+  n_backtrack_operations(0),
+  n_linear_iterations(0),
+  residual_norm(0),
+  step_length(0)
+{}
+
+
+
+KINSOLStatistics KINSOLStatistics::operator+(const KINSOLStatistics &other) const
+{
+  KINSOLStatistics ret(other);
+  ret.n_nonlinear_iterations += n_nonlinear_iterations;
+  ret.n_residual_evaluations += n_residual_evaluations;
+  ret.n_beta_condition_failures += n_beta_condition_failures;
+  ret.n_backtrack_operations += n_backtrack_operations;
+  ret.n_linear_iterations += n_linear_iterations;
+  ret.residual = residual + other.residual;
+  ret.setup_jacobian = setup_jacobian + other.setup_jacobian;
+  ret.solve_linear_system = solve_linear_system + other.solve_linear_system;
+  ret.jacobian_vmult = jacobian_vmult + other.jacobian_vmult;
+  ret.setup_preconditioner = setup_preconditioner + other.setup_preconditioner;
+  ret.solve_preconditioner = solve_preconditioner + other.solve_preconditioner;
+  return ret;
+}
+
+
+
+KINSOLStatistics KINSOLStatistics::operator-(const KINSOLStatistics &previous) const
+{
+  KINSOLStatistics ret(*this);
+  ret.n_nonlinear_iterations -= previous.n_nonlinear_iterations;
+  ret.n_residual_evaluations -= previous.n_residual_evaluations;
+  ret.n_beta_condition_failures -= previous.n_beta_condition_failures;
+  ret.n_backtrack_operations -= previous.n_backtrack_operations;
+  ret.n_linear_iterations -= previous.n_linear_iterations;
+  ret.residual = residual - previous.residual;
+  ret.setup_jacobian = setup_jacobian - previous.setup_jacobian;
+  ret.solve_linear_system = solve_linear_system - previous.solve_linear_system;
+  ret.jacobian_vmult = jacobian_vmult - previous.jacobian_vmult;
+  ret.setup_preconditioner = setup_preconditioner - previous.setup_preconditioner;
+  ret.solve_preconditioner = solve_preconditioner - previous.solve_preconditioner;
+  return ret;
+}
+
+
+
+void KINSOLStatistics::get_entries(std::vector<std::pair<std::string, double> > &entries) const
+{
+  entries.clear();
+  entries.push_back(std::make_pair("n_nonlinear_iterations", (double)n_nonlinear_iterations));
+  entries.push_back(std::make_pair("n_residual_evaluations", (double)n_residual_evaluations));
+  entries.push_back(std::make_pair("n_beta_condition_failures", (double)n_beta_condition_failures));
+  entries.push_back(std::make_pair("n_backtrack_operations", (double)n_backtrack_operations));
+  entries.push_back(std::make_pair("n_linear_iterations", (double)n_linear_iterations));
+  entries.push_back(std::make_pair("residual_norm", residual_norm));
+  entries.push_back(std::make_pair("step_length", step_length));
+  add_entries(entries, "residual", residual);
+  add_entries(entries, "setup_jacobian", setup_jacobian);
+  add_entries(entries, "solve_linear_system", solve_linear_system);
+  add_entries(entries, "jacobian_vmult", jacobian_vmult);
+  add_entries(entries, "setup_preconditioner", setup_preconditioner);
+  add_entries(entries, "solve_preconditioner", solve_preconditioner);
+}
+
+D2K_NAMESPACE_CLOSE
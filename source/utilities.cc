@@ -14,12 +14,28 @@
 //-----------------------------------------------------------
 
 #include <deal2lkit/utilities.h>
+
+#include <deal.II/base/parallel.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <numeric>
 #include <vector>
 #include <fstream>
 #include <thread>
 
+#include <fcntl.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 
 D2K_NAMESPACE_OPEN
@@ -73,6 +89,193 @@ int TimeUtilities::get_num_measures()
   return times.size();
 }
 
+// protect the helper functions
+namespace
+{
+  /**
+   * Write and read a buffer of @p size bytes, to evict the data of
+   * the benchmarked function from the caches.
+   */
+  void flush_cache(const std::size_t size)
+  {
+    static std::vector<char> buffer;
+    buffer.resize(size);
+    for (std::size_t i=0; i<size; i+=64)
+      buffer[i] = static_cast<char>(buffer[i] + 1);
+
+    volatile char sum = 0;
+    for (std::size_t i=0; i<size; i+=64)
+      sum += buffer[i];
+    (void)sum;
+  }
+
+  /**
+   * Quantile of order 0.975 of the Student's t distribution with
+   * @p n degrees of freedom. Between the tabulated values, the one of
+   * the lower number of degrees of freedom is used, which is larger
+   * and gives a conservative confidence interval.
+   */
+  double student_t_975(const unsigned int n)
+  {
+    static const double table[] =
+    {
+      12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+      2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+      2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (n == 0)
+      return std::numeric_limits<double>::infinity();
+    if (n <= 30)
+      return table[n-1];
+    if (n < 40)
+      return 2.042;
+    if (n < 60)
+      return 2.021;
+    if (n < 120)
+      return 2.000;
+    return 1.980;
+  }
+}
+
+void TimeUtilities::clear()
+{
+  AssertThrow(status == true,
+              ExcMessage("Use get_end_time() before clear().") );
+  times.clear();
+}
+
+unsigned int TimeUtilities::benchmark(const std::function<void()> &function,
+                                      const unsigned int n_warmup_runs,
+                                      const double relative_confidence,
+                                      const unsigned int min_runs,
+                                      const unsigned int max_runs,
+                                      const double max_time,
+                                      const std::size_t cache_flush_size)
+{
+  AssertThrow(status == true,
+              ExcMessage("Use get_end_time() before benchmark().") );
+  AssertThrow(min_runs <= max_runs,
+              ExcMessage("The minimum number of runs is larger than the maximum.") );
+
+  for (unsigned int i=0; i<n_warmup_runs; ++i)
+    {
+      if (cache_flush_size > 0)
+        flush_cache(cache_flush_size);
+      function();
+    }
+
+  // The statistics are computed on the measures of this call only
+  TimeUtilities runs;
+  double total_time = 0;
+  while (runs.times.size() < max_runs)
+    {
+      if (cache_flush_size > 0)
+        flush_cache(cache_flush_size);
+
+      runs.get_start_time();
+      function();
+      runs.get_end_time();
+      total_time += runs.times.back();
+
+      if (runs.times.size() >= min_runs &&
+          (total_time >= max_time ||
+           runs.get_confidence_interval() <= relative_confidence*runs.get_mean()))
+        break;
+    }
+
+  times.insert(times.end(), runs.times.begin(), runs.times.end());
+  return runs.times.size();
+}
+
+double TimeUtilities::get_min() const
+{
+  AssertThrow(times.size() > 0, ExcMessage("There are no measures."));
+  return *std::min_element(times.begin(), times.end());
+}
+
+double TimeUtilities::get_max() const
+{
+  AssertThrow(times.size() > 0, ExcMessage("There are no measures."));
+  return *std::max_element(times.begin(), times.end());
+}
+
+double TimeUtilities::get_mean() const
+{
+  AssertThrow(times.size() > 0, ExcMessage("There are no measures."));
+  return std::accumulate(times.begin(), times.end(), 0.0)/times.size();
+}
+
+double TimeUtilities::get_median() const
+{
+  return get_percentile(50);
+}
+
+double TimeUtilities::get_percentile(const double p) const
+{
+  AssertThrow(times.size() > 0, ExcMessage("There are no measures."));
+  AssertThrow(p >= 0 && p <= 100, ExcMessage("The percentile must be between 0 and 100."));
+
+  std::vector<double> sorted(times);
+  std::sort(sorted.begin(), sorted.end());
+
+  const double position = p/100*(sorted.size()-1);
+  const std::size_t below = static_cast<std::size_t>(std::floor(position));
+  const std::size_t above = std::min(below+1, sorted.size()-1);
+  return sorted[below] + (position-below)*(sorted[above]-sorted[below]);
+}
+
+double TimeUtilities::get_standard_deviation() const
+{
+  if (times.size() < 2)
+    return 0;
+
+  const double mean = get_mean();
+  double sum = 0;
+  for (auto t : times)
+    sum += (t-mean)*(t-mean);
+  return std::sqrt(sum/(times.size()-1));
+}
+
+double TimeUtilities::get_confidence_interval() const
+{
+  if (times.size() < 2)
+    return std::numeric_limits<double>::infinity();
+  return student_t_975(times.size()-1)*get_standard_deviation()/std::sqrt(times.size());
+}
+
+void TimeUtilities::write_csv(std::ostream &out,
+                              const std::string &name,
+                              const bool header) const
+{
+  if (header)
+    out << "name,measures,min,median,p95,max,mean,std_dev" << std::endl;
+  out << name << ',' << times.size() << std::setprecision(6)
+      << ',' << get_min()
+      << ',' << get_median()
+      << ',' << get_percentile(95)
+      << ',' << get_max()
+      << ',' << get_mean()
+      << ',' << get_standard_deviation() << std::endl;
+}
+
+void TimeUtilities::write_json(std::ostream &out,
+                               const std::string &name) const
+{
+  out << std::setprecision(6)
+      << "{\"name\": \"" << name << "\", "
+      << "\"measures\": " << times.size() << ", "
+      << "\"min\": " << get_min() << ", "
+      << "\"median\": " << get_median() << ", "
+      << "\"p95\": " << get_percentile(95) << ", "
+      << "\"max\": " << get_max() << ", "
+      << "\"mean\": " << get_mean() << ", "
+      << "\"std_dev\": " << get_standard_deviation() << ", "
+      << "\"times\": [";
+  for (unsigned int i=0; i<times.size(); ++i)
+    out << (i == 0 ? "" : ", ") << times[i];
+  out << "]}" << std::endl;
+}
+
 void append_to_file(const std::string &in_file, const std::string &out_file)
 {
   std::ifstream ifile(in_file,  std::ios::in);
@@ -114,14 +317,155 @@ std::string get_next_available_directory_name(const std::string &base, int n_dig
   return base + dealii::Utilities::int_to_string (index, n_digits);
 }
 
+// protect the helper functions
+namespace
+{
+  /**
+   * Throw an exception with the description of the error code @p
+   * error, which is the value of errno saved right after the call that
+   * failed. If @p error is zero, no reason is given.
+   */
+  void throw_errno(const std::string &what, const int error)
+  {
+    AssertThrow(false, ExcMessage(error == 0 ? what :
+                                  what + ": " + std::strerror(error)));
+  }
+
+  /**
+   * Return @p destination, or destination/basename(file) if @p
+   * destination is a directory, as cp and mv do.
+   */
+  std::string target_name(const std::string &file,
+                          const std::string &destination)
+  {
+    struct stat st;
+    if (stat(destination.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+      {
+        const std::size_t slash = file.find_last_of('/');
+        return destination + "/" +
+               (slash == std::string::npos ? file : file.substr(slash+1));
+      }
+    return destination;
+  }
+
+  /**
+   * Copy the content of @p file to @p new_file. If @p only_if_newer
+   * is true, nothing is done when @p new_file has the same size and
+   * was modified after @p file. Nothing is done either when @p
+   * new_file is @p file itself, which would otherwise be truncated
+   * before being read.
+   */
+  void copy_file_content(const std::string &file,
+                         const std::string &new_file,
+                         const bool only_if_newer)
+  {
+    const int in = open(file.c_str(), O_RDONLY);
+    if (in < 0)
+      throw_errno("Cannot open " + file, errno);
+
+    struct stat in_st, out_st;
+    if (fstat(in, &in_st) != 0)
+      {
+        const int error = errno;
+        close(in);
+        throw_errno("Cannot stat " + file, error);
+      }
+
+    if (stat(new_file.c_str(), &out_st) == 0)
+      {
+        const bool same_file = (out_st.st_dev == in_st.st_dev &&
+                                out_st.st_ino == in_st.st_ino);
+        const bool up_to_date = (only_if_newer &&
+                                 out_st.st_size == in_st.st_size &&
+                                 out_st.st_mtime > in_st.st_mtime);
+        if (same_file || up_to_date)
+          {
+            close(in);
+            return;
+          }
+      }
+
+    const int out = open(new_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                         in_st.st_mode & 0777);
+    if (out < 0)
+      {
+        const int error = errno;
+        close(in);
+        throw_errno("Cannot create " + new_file, error);
+      }
+
+    // Value of errno after the call that failed, or zero if the copy
+    // stopped because the file ended before its original size
+    int error = 0;
+    off_t remaining = in_st.st_size;
+    bool use_read_write = false;
+#ifdef __linux__
+    // The copy is done by the kernel, without buffers in user space
+    while (remaining > 0)
+      {
+        const ssize_t n = sendfile(out, in, nullptr, remaining);
+        if (n > 0)
+          remaining -= n;
+        else if (n < 0 && errno == EINTR)
+          continue;
+        else
+          {
+            if (n < 0)
+              error = errno;
+            use_read_write = (error == EINVAL || error == ENOSYS);
+            if (use_read_write)
+              error = 0;
+            break;
+          }
+      }
+#else
+    use_read_write = true;
+#endif
+
+    if (use_read_write)
+      {
+        std::vector<char> buffer(1<<16);
+        ssize_t n;
+        while ((n = read(in, &buffer[0], buffer.size())) != 0)
+          {
+            if (n < 0 && errno == EINTR)
+              continue;
+            if (n < 0)
+              {
+                error = errno;
+                break;
+              }
+            const ssize_t written = write(out, &buffer[0], n);
+            if (written != n)
+              {
+                error = (written < 0 ? errno : ENOSPC);
+                break;
+              }
+            remaining -= n;
+          }
+      }
+
+    close(in);
+    if (close(out) != 0 && error == 0)
+      error = errno;
+    if (error != 0 || remaining > 0)
+      throw_errno("Cannot copy " + file + " to " + new_file, error);
+  }
+}
+
 bool create_directory(const std::string &name)
 {
-  Assert((std::find(name.begin(), name.end(), ' ') == name.end()),
-         ExcMessage("Invalid name of directory."));
-  std::string cmd = "mkdir -p " + name;
-  int status;
-  status = std::system(cmd.c_str());
-  AssertThrow(status == 0, ExcCannottExecuteCommand(cmd));
+  // Create all the parents, as mkdir -p does
+  std::size_t pos = 0;
+  while (pos != std::string::npos)
+    {
+      pos = name.find('/', pos+1);
+      const std::string dir = name.substr(0, pos);
+      if (dir.empty() || dir == "." || dir == "..")
+        continue;
+      if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+        throw_errno("Cannot create directory " + dir, errno);
+    }
   return dir_exists(name);
 }
 
@@ -129,7 +473,6 @@ bool copy_files(const std::string &files, const std::string &destination)
 {
   create_directory("./"+destination);
   bool result = true;
-  int status;
   std::vector<std::string> strs;
   std::string new_file;
   strs = dealii::Utilities::split_string_list(files, ' ');
@@ -137,9 +480,7 @@ bool copy_files(const std::string &files, const std::string &destination)
     {
       Assert(file_exists(strs[i]), ExcMessage("Invalid name of file"));
       new_file = destination+"/"+strs[i];
-      std::string cmd = "cp " + strs[i] + " " + new_file;
-      status = std::system( cmd.c_str() );
-      AssertThrow(status == 0, ExcCannottExecuteCommand(cmd));
+      copy_file_content(strs[i], new_file, true);
       result &= file_exists(new_file);
     }
   return result;
@@ -148,70 +489,189 @@ bool copy_files(const std::string &files, const std::string &destination)
 bool copy_file(const std::string &file, const std::string &new_file)
 {
   Assert(file_exists(file),ExcMessage("No such file or directory"));
-  std::string cmd = "cp " + file + " " + new_file ;
-  int status;
-  status = std::system(cmd.c_str());
-  AssertThrow(status == 0, ExcCannottExecuteCommand(cmd));
-  return file_exists(new_file);
+  const std::string target = target_name(file, new_file);
+  copy_file_content(file, target, true);
+  return file_exists(target);
 }
 
 bool rename_file(const std::string &file, const std::string &new_file)
 {
   Assert(file_exists(file),ExcMessage("No such file or directory"));
-  std::string cmd = "mv " + file + " " + new_file;
-  int status;
-  status = std::system(cmd.c_str());
-  AssertThrow(status == 0, ExcCannottExecuteCommand(cmd));
-  return file_exists(new_file);
+  const std::string target = target_name(file, new_file);
+  if (std::rename(file.c_str(), target.c_str()) != 0)
+    {
+      // rename does not work across file systems
+      if (errno != EXDEV)
+        throw_errno("Cannot rename " + file + " to " + target, errno);
+      copy_file_content(file, target, false);
+      if (std::remove(file.c_str()) != 0)
+        throw_errno("Cannot remove " + file, errno);
+    }
+  return file_exists(target);
 }
 
 
 #ifdef D2K_WITH_SUNDIALS
 
+// protect the helper functions
+namespace
+{
+  /**
+   * Minimum number of entries copied by each thread.
+   */
+  const unsigned int copy_grain_size = 1<<16;
+
+  /**
+   * Copy @p n entries from @p src to @p dst. Large arrays are split
+   * among the threads.
+   */
+  void copy_array(double *dst, const double *src, const std::size_t n)
+  {
+    parallel::apply_to_subranges(std::size_t(0), n,
+                                 [dst, src](const std::size_t begin,
+                                            const std::size_t end)
+    {
+      std::memcpy(dst+begin, src+begin, (end-begin)*sizeof(double));
+    },
+    copy_grain_size);
+  }
+
+  /**
+   * Local part of the data of an N_Vector.
+   */
+  double *local_data(const N_Vector &v)
+  {
+#ifdef DEAL_II_WITH_MPI
+    return NV_DATA_P(v);
+#else
+    return NV_DATA_S(v);
+#endif
+  }
+
+  std::size_t local_length(const N_Vector &v)
+  {
+#ifdef DEAL_II_WITH_MPI
+    return NV_LOCLENGTH_P(v);
+#else
+    return NV_LENGTH_S(v);
+#endif
+  }
+
+#ifdef DEAL_II_WITH_MPI
+
+  // The locally owned entries of the distributed vectors are stored
+  // in a single array, ordered as the locally owned index set, even
+  // when it is not a contiguous range. They can be copied directly,
+  // and there is no need to compress() the vectors, which is a
+  // collective operation.
+
+#ifdef DEAL_II_WITH_TRILINOS
+
+  void copy_local(TrilinosWrappers::MPI::Vector &dst, const double *src)
+  {
+    Assert(!dst.has_ghost_elements(), ExcGhostsPresent());
+    copy_array(dst.begin(), src, dst.local_size());
+  }
+
+  void copy_local(double *dst, const TrilinosWrappers::MPI::Vector &src)
+  {
+    copy_array(dst, src.begin(), src.local_size());
+  }
+
+#endif //DEAL_II_WITH_TRILINOS
+
+#ifdef DEAL_II_WITH_PETSC
+
+  void copy_local(PETScWrappers::MPI::Vector &dst, const double *src)
+  {
+    Assert(!dst.has_ghost_elements(), ExcGhostsPresent());
+    Vec vec = static_cast<const Vec &>(dst);
+    PetscScalar *data;
+    PetscErrorCode ierr = VecGetArray(vec, &data);
+    AssertThrow(ierr == 0, ExcPETScError(ierr));
+    copy_array(data, src, dst.local_size());
+    ierr = VecRestoreArray(vec, &data);
+    AssertThrow(ierr == 0, ExcPETScError(ierr));
+  }
+
+  void copy_local(double *dst, const PETScWrappers::MPI::Vector &src)
+  {
+    Vec vec = static_cast<const Vec &>(src);
+    const PetscScalar *data;
+    PetscErrorCode ierr = VecGetArrayRead(vec, &data);
+    AssertThrow(ierr == 0, ExcPETScError(ierr));
+    copy_array(dst, data, src.local_size());
+    ierr = VecRestoreArrayRead(vec, &data);
+    AssertThrow(ierr == 0, ExcPETScError(ierr));
+  }
+
+#endif //DEAL_II_WITH_PETSC
+
+#endif //mpi
+
+  void copy_local(Vector<double> &dst, const double *src)
+  {
+    copy_array(dst.begin(), src, dst.size());
+  }
+
+  void copy_local(double *dst, const Vector<double> &src)
+  {
+    copy_array(dst, src.begin(), src.size());
+  }
+
+  /**
+   * The N_Vector stores the locally owned entries of all the blocks,
+   * one block after the other.
+   */
+  template<typename VEC>
+  void copy_to_blocks(VEC &dst, const N_Vector &src)
+  {
+    const double *data = local_data(src);
+    for (unsigned int b=0; b<dst.n_blocks(); ++b)
+      {
+        copy_local(dst.block(b), data);
+        data += dst.block(b).locally_owned_elements().n_elements();
+      }
+  }
+
+  template<typename VEC>
+  void copy_from_blocks(N_Vector &dst, const VEC &src)
+  {
+    double *data = local_data(dst);
+    for (unsigned int b=0; b<src.n_blocks(); ++b)
+      {
+        copy_local(data, src.block(b));
+        data += src.block(b).locally_owned_elements().n_elements();
+      }
+  }
+}
+
 #ifdef DEAL_II_WITH_MPI
 
 #ifdef DEAL_II_WITH_TRILINOS
 
 void copy(TrilinosWrappers::MPI::Vector &dst, const N_Vector &src)
 {
-  IndexSet is = dst.locally_owned_elements();
-  AssertDimension(is.n_elements(), NV_LOCLENGTH_P(src));
-  for (unsigned int i=0; i<is.n_elements(); ++i)
-    {
-      dst[is.nth_index_in_set(i)] = NV_Ith_P(src, i);
-    }
-  dst.compress(VectorOperation::insert);
+  AssertDimension(dst.local_size(), NV_LOCLENGTH_P(src));
+  copy_local(dst, local_data(src));
 }
 
 void copy(N_Vector &dst, const TrilinosWrappers::MPI::Vector &src)
 {
-  IndexSet is = src.locally_owned_elements();
-  AssertDimension(is.n_elements(), NV_LOCLENGTH_P(dst));
-  for (unsigned int i=0; i<is.n_elements(); ++i)
-    {
-      NV_Ith_P(dst, i) = src[is.nth_index_in_set(i)];
-    }
+  AssertDimension(src.local_size(), NV_LOCLENGTH_P(dst));
+  copy_local(local_data(dst), src);
 }
 
 void copy(TrilinosWrappers::MPI::BlockVector &dst, const N_Vector &src)
 {
-  IndexSet is = dst.locally_owned_elements();
-  AssertDimension(is.n_elements(), NV_LOCLENGTH_P(src));
-  for (unsigned int i=0; i<is.n_elements(); ++i)
-    {
-      dst[is.nth_index_in_set(i)] = NV_Ith_P(src, i);
-    }
-  dst.compress(VectorOperation::insert);
+  AssertDimension(dst.locally_owned_elements().n_elements(), NV_LOCLENGTH_P(src));
+  copy_to_blocks(dst, src);
 }
 
 void copy(N_Vector &dst, const TrilinosWrappers::MPI::BlockVector &src)
 {
-  IndexSet is = src.locally_owned_elements();
-  AssertDimension(is.n_elements(), NV_LOCLENGTH_P(dst));
-  for (unsigned int i=0; i<is.n_elements(); ++i)
-    {
-      NV_Ith_P(dst, i) = src[is.nth_index_in_set(i)];
-    }
+  AssertDimension(src.locally_owned_elements().n_elements(), NV_LOCLENGTH_P(dst));
+  copy_from_blocks(dst, src);
 }
 
 #endif //DEAL_II_WITH_TRILINOS
@@ -220,44 +680,26 @@ void copy(N_Vector &dst, const TrilinosWrappers::MPI::BlockVector &src)
 
 void copy(PETScWrappers::MPI::Vector &dst, const N_Vector &src)
 {
-  IndexSet is = dst.locally_owned_elements();
-  AssertDimension(is.n_elements(), NV_LOCLENGTH_P(src));
-  for (unsigned int i=0; i<is.n_elements(); ++i)
-    {
-      dst[is.nth_index_in_set(i)] = NV_Ith_P(src, i);
-    }
-  dst.compress(VectorOperation::insert);
+  AssertDimension(dst.local_size(), NV_LOCLENGTH_P(src));
+  copy_local(dst, local_data(src));
 }
 
 void copy(N_Vector &dst, const PETScWrappers::MPI::Vector &src)
 {
-  IndexSet is = src.locally_owned_elements();
-  AssertDimension(is.n_elements(), NV_LOCLENGTH_P(dst));
-  for (unsigned int i=0; i<is.n_elements(); ++i)
-    {
-      NV_Ith_P(dst, i) = src[is.nth_index_in_set(i)];
-    }
+  AssertDimension(src.local_size(), NV_LOCLENGTH_P(dst));
+  copy_local(local_data(dst), src);
 }
 
 void copy(PETScWrappers::MPI::BlockVector &dst, const N_Vector &src)
 {
-  IndexSet is = dst.locally_owned_elements();
-  AssertDimension(is.n_elements(), NV_LOCLENGTH_P(src));
-  for (unsigned int i=0; i<is.n_elements(); ++i)
-    {
-      dst[is.nth_index_in_set(i)] = NV_Ith_P(src, i);
-    }
-  dst.compress(VectorOperation::insert);
+  AssertDimension(dst.locally_owned_elements().n_elements(), NV_LOCLENGTH_P(src));
+  copy_to_blocks(dst, src);
 }
 
 void copy(N_Vector &dst, const PETScWrappers::MPI::BlockVector &src)
 {
-  IndexSet is = src.locally_owned_elements();
-  AssertDimension(is.n_elements(), NV_LOCLENGTH_P(dst));
-  for (unsigned int i=0; i<is.n_elements(); ++i)
-    {
-      NV_Ith_P(dst, i) = src[is.nth_index_in_set(i)];
-    }
+  AssertDimension(src.locally_owned_elements().n_elements(), NV_LOCLENGTH_P(dst));
+  copy_from_blocks(dst, src);
 }
 
 #endif //DEAL_II_WITH_PETSC
@@ -266,36 +708,14 @@ void copy(N_Vector &dst, const PETScWrappers::MPI::BlockVector &src)
 
 void copy(BlockVector<double> &dst, const N_Vector &src)
 {
-#ifdef DEAL_II_WITH_MPI
-  AssertDimension((unsigned int)NV_LOCLENGTH_P(src), dst.size());
-#else
-  AssertDimension((unsigned int)NV_LENGTH_S(src), dst.size());
-#endif
-  for (unsigned int i=0; i<dst.size(); ++i)
-    {
-#ifdef DEAL_II_WITH_MPI
-      dst[i] = NV_Ith_P(src, i);
-#else
-      dst[i] = NV_Ith_S(src, i);
-#endif
-    }
+  AssertDimension(local_length(src), dst.size());
+  copy_to_blocks(dst, src);
 }
 
 void copy(N_Vector &dst, const BlockVector<double> &src)
 {
-#ifdef DEAL_II_WITH_MPI
-  AssertDimension((unsigned int)NV_LOCLENGTH_P(dst), src.size());
-#else
-  AssertDimension((unsigned int)NV_LENGTH_S(dst), src.size());
-#endif
-  for (unsigned int i=0; i<src.size(); ++i)
-    {
-#ifdef DEAL_II_WITH_MPI
-      NV_Ith_P(dst, i) = src[i];
-#else
-      NV_Ith_S(dst, i) = src[i];
-#endif
-    }
+  AssertDimension(local_length(dst), src.size());
+  copy_from_blocks(dst, src);
 }
 
 #endif // sundials
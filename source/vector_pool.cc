@@ -0,0 +1,317 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+#include <deal2lkit/vector_pool.h>
+
+#include <deal.II/base/index_set.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/block_vector.h>
+#ifdef DEAL_II_WITH_TRILINOS
+#include <deal.II/lac/trilinos_block_vector.h>
+#include <deal.II/lac/trilinos_parallel_block_vector.h>
+#include <deal.II/lac/trilinos_vector.h>
+#endif
+#ifdef DEAL_II_WITH_PETSC
+#include <deal.II/lac/petsc_block_vector.h>
+#include <deal.II/lac/petsc_parallel_block_vector.h>
+#include <deal.II/lac/petsc_vector.h>
+#endif
+
+#include <algorithm>
+
+D2K_NAMESPACE_OPEN
+
+// protect the helper functions
+namespace
+{
+  /**
+   * MPI communicator of @p v. Serial vectors live on MPI_COMM_SELF.
+   */
+  template<typename VEC>
+  MPI_Comm get_communicator(const VEC &)
+  {
+    return MPI_COMM_SELF;
+  }
+
+#ifdef DEAL_II_WITH_MPI
+#ifdef DEAL_II_WITH_TRILINOS
+  template<>
+  MPI_Comm get_communicator(const TrilinosWrappers::MPI::Vector &v)
+  {
+    return v.get_mpi_communicator();
+  }
+
+  template<>
+  MPI_Comm get_communicator(const TrilinosWrappers::MPI::BlockVector &v)
+  {
+    return (v.n_blocks() == 0 ? MPI_COMM_SELF :
+            v.block(0).get_mpi_communicator());
+  }
+#endif
+
+#ifdef DEAL_II_WITH_PETSC
+  template<>
+  MPI_Comm get_communicator(const PETScWrappers::MPI::Vector &v)
+  {
+    return v.get_mpi_communicator();
+  }
+
+  template<>
+  MPI_Comm get_communicator(const PETScWrappers::MPI::BlockVector &v)
+  {
+    return (v.n_blocks() == 0 ? MPI_COMM_SELF :
+            v.block(0).get_mpi_communicator());
+  }
+#endif
+#endif
+
+  /**
+   * Return true if @p a and @p b have the same size, the same locally
+   * owned elements and the same communicator, and none of them has
+   * ghost elements.
+   */
+  template<typename VEC>
+  bool same_vector_layout(const VEC &a, const VEC &b)
+  {
+    if (a.has_ghost_elements() || b.has_ghost_elements() ||
+        a.size() != b.size())
+      return false;
+
+#ifdef DEAL_II_WITH_MPI
+    const MPI_Comm comm_a = get_communicator(a);
+    const MPI_Comm comm_b = get_communicator(b);
+    if (comm_a != comm_b)
+      {
+        int result;
+        MPI_Comm_compare(comm_a, comm_b, &result);
+        if (result != MPI_IDENT)
+          return false;
+      }
+#endif
+
+    return a.locally_owned_elements() == b.locally_owned_elements();
+  }
+
+  /**
+   * Same as above, but also check the blocks.
+   */
+  template<typename VEC>
+  bool same_block_layout(const VEC &a, const VEC &b)
+  {
+    if (a.n_blocks() != b.n_blocks())
+      return false;
+    for (unsigned int i=0; i<a.n_blocks(); ++i)
+      if (a.block(i).size() != b.block(i).size())
+        return false;
+    return same_vector_layout(a, b);
+  }
+
+  template<typename VEC>
+  bool same_layout(const VEC &a, const VEC &b)
+  {
+    return same_vector_layout(a, b);
+  }
+
+  template<>
+  bool same_layout(const BlockVector<double> &a, const BlockVector<double> &b)
+  {
+    return same_block_layout(a, b);
+  }
+
+#ifdef DEAL_II_WITH_MPI
+#ifdef DEAL_II_WITH_TRILINOS
+  template<>
+  bool same_layout(const TrilinosWrappers::MPI::BlockVector &a,
+                   const TrilinosWrappers::MPI::BlockVector &b)
+  {
+    return same_block_layout(a, b);
+  }
+#endif
+
+#ifdef DEAL_II_WITH_PETSC
+  template<>
+  bool same_layout(const PETScWrappers::MPI::BlockVector &a,
+                   const PETScWrappers::MPI::BlockVector &b)
+  {
+    return same_block_layout(a, b);
+  }
+#endif
+#endif
+}
+
+
+
+template<typename VEC>
+VectorPool<VEC>::Data::Data() :
+  n_allocations(0),
+  memory(0),
+  finalize_hook(false),
+  finalized(false)
+{}
+
+
+
+template<typename VEC>
+void VectorPool<VEC>::Data::release_unused()
+{
+  for (unsigned int i=0; i<unused.size(); ++i)
+    memory -= std::min(memory, unused[i]->memory_consumption());
+  unused.clear();
+}
+
+
+
+template<typename VEC>
+int VectorPool<VEC>::release_at_finalize(MPI_Comm, int, void *attribute, void *)
+{
+  Data &data = *static_cast<Data *>(attribute);
+  std::lock_guard<std::mutex> lock(data.mutex);
+  data.release_unused();
+  data.finalized = true;
+  return 0;
+}
+
+
+
+template<typename VEC>
+VectorPool<VEC>::VectorPool() :
+  data(SP(new Data()))
+{}
+
+
+
+template<typename VEC>
+VectorPool<VEC> &VectorPool<VEC>::get_pool()
+{
+  static VectorPool<VEC> pool;
+  return pool;
+}
+
+
+
+template<typename VEC>
+shared_ptr<VEC>
+VectorPool<VEC>::get(const VEC &model,
+                     const std::function<shared_ptr<VEC>()> &create_new_vector)
+{
+  shared_ptr<VEC> v;
+  {
+    std::lock_guard<std::mutex> lock(data->mutex);
+
+#ifdef DEAL_II_WITH_MPI
+    // Release the unused vectors before MPI_Finalize destroys the
+    // objects they depend on, instead of at the destruction of the
+    // static pool.
+    int mpi_initialized;
+    MPI_Initialized(&mpi_initialized);
+    if (!data->finalize_hook && mpi_initialized)
+      {
+        int keyval;
+        MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN,
+                               &VectorPool<VEC>::release_at_finalize,
+                               &keyval, nullptr);
+        MPI_Comm_set_attr(MPI_COMM_SELF, keyval, data.get());
+        data->finalize_hook = true;
+      }
+#endif
+
+    for (unsigned int i=0; i<data->unused.size(); ++i)
+      if (same_layout(*data->unused[i], model))
+        {
+          v = data->unused[i];
+          data->unused[i] = data->unused.back();
+          data->unused.pop_back();
+          break;
+        }
+  }
+
+  if (v)
+    *v = 0;
+  else
+    {
+      v = create_new_vector();
+      const std::size_t bytes = v->memory_consumption();
+      std::lock_guard<std::mutex> lock(data->mutex);
+      ++data->n_allocations;
+      data->memory += bytes;
+    }
+
+  // The returned pointer does not own the vector: when it is destroyed
+  // the owner goes back to the pool.
+  shared_ptr<Data> pool_data = data;
+  return shared_ptr<VEC>(v.get(), [pool_data, v](VEC *)
+  {
+    std::lock_guard<std::mutex> lock(pool_data->mutex);
+    if (pool_data->finalized || v->has_ghost_elements())
+      pool_data->memory -= std::min(pool_data->memory, v->memory_consumption());
+    else
+      pool_data->unused.push_back(v);
+  });
+}
+
+
+
+template<typename VEC>
+void VectorPool<VEC>::release_unused()
+{
+  std::lock_guard<std::mutex> lock(data->mutex);
+  data->release_unused();
+}
+
+
+
+template<typename VEC>
+unsigned int VectorPool<VEC>::n_allocations() const
+{
+  std::lock_guard<std::mutex> lock(data->mutex);
+  return data->n_allocations;
+}
+
+
+
+template<typename VEC>
+unsigned int VectorPool<VEC>::n_unused() const
+{
+  std::lock_guard<std::mutex> lock(data->mutex);
+  return data->unused.size();
+}
+
+
+
+template<typename VEC>
+std::size_t VectorPool<VEC>::memory_consumption() const
+{
+  std::lock_guard<std::mutex> lock(data->mutex);
+  return data->memory;
+}
+
+D2K_NAMESPACE_CLOSE
+
+template class deal2lkit::VectorPool<Vector<double> >;
+template class deal2lkit::VectorPool<BlockVector<double> >;
+
+#ifdef DEAL_II_WITH_MPI
+
+#ifdef DEAL_II_WITH_TRILINOS
+template class deal2lkit::VectorPool<TrilinosWrappers::MPI::Vector>;
+template class deal2lkit::VectorPool<TrilinosWrappers::MPI::BlockVector>;
+#endif
+
+#ifdef DEAL_II_WITH_PETSC
+template class deal2lkit::VectorPool<PETScWrappers::MPI::Vector>;
+template class deal2lkit::VectorPool<PETScWrappers::MPI::BlockVector>;
+#endif
+
+#endif
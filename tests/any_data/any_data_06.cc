@@ -0,0 +1,51 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Test that the memory of the copies is counted, also after they are
+// resized and in copies of the AnyData object, while references are
+// not counted
+
+#include "../tests.h"
+#include <deal2lkit/any_data.h>
+
+
+
+using namespace deal2lkit;
+
+
+int main ()
+{
+  initlog();
+
+  AnyData data;
+  const std::size_t empty = data.memory_consumption();
+
+  std::vector<double> external(1000);
+  data.add_ref(external, "ref");
+  deallog << "Reference: "
+          << (data.memory_consumption()-empty < 1000*sizeof(double)) << std::endl;
+
+  data.add_copy(std::vector<double>(1000), "copy");
+  const std::size_t with_copy = data.memory_consumption();
+  deallog << "Copy: "
+          << (with_copy-empty >= 1000*sizeof(double)) << std::endl;
+
+  AnyData other(data);
+  other.get<std::vector<double> >("copy").resize(2000);
+  deallog << "Resized copy: "
+          << (other.memory_consumption()-with_copy >= 1000*sizeof(double))
+          << ", original: "
+          << (data.memory_consumption() == with_copy) << std::endl;
+}
@@ -0,0 +1,108 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Test error handler with three components, two names, and all the
+// norms on the first one, which is added up with the second. The
+// errors must be the ones given by VectorTools::integrate_difference().
+
+#include "../tests.h"
+
+#include <deal2lkit/error_handler.h>
+#include <deal.II/base/function_lib.h>
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_system.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/numerics/vector_tools.h>
+
+#include <sstream>
+
+
+using namespace deal2lkit;
+
+double error(const DoFHandler<2> &dh,
+             const Vector<double> &sol,
+             const Function<2> &exact,
+             const unsigned int component,
+             const VectorTools::NormType norm)
+{
+  Vector<double> cellwise(dh.get_triangulation().n_active_cells());
+  ComponentSelectFunction<2> select(component, exact.n_components);
+  VectorTools::integrate_difference(dh, sol, exact, cellwise,
+                                    QGauss<2>(4), norm, &select);
+  if (norm == VectorTools::Linfty_norm || norm == VectorTools::W1infty_norm)
+    return cellwise.linfty_norm();
+  return cellwise.l2_norm();
+}
+
+int main ()
+{
+  initlog();
+
+  ErrorHandler<> eh("Error handler", "u,u,p",
+                    "Linfty, L2, W1infty, H1; AddUp; Linfty, L2");
+
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/error_handler_10.prm",
+                                "used_parameters.prm");
+
+  Triangulation<2> tria;
+  GridGenerator::hyper_cube(tria, -1, 1);
+  tria.refine_global(3);
+
+  FESystem<2> fe(FE_Q<2>(1), 3);
+  DoFHandler<2> dh(tria);
+  dh.distribute_dofs(fe);
+
+  // A different error on each component
+  std::vector<double> values(3);
+  values[0] = 0.1;
+  values[1] = 0.5;
+  values[2] = -0.2;
+  Vector<double> sol(dh.n_dofs());
+  VectorTools::interpolate(dh, ConstantFunction<2>(values), sol);
+
+  Functions::CosineFunction<2> exact(3);
+  eh.error_from_exact(dh, sol, exact);
+
+  std::map<std::string, double> expected;
+  expected["u_Linfty"] = std::max(error(dh, sol, exact, 0, VectorTools::Linfty_norm),
+                                  error(dh, sol, exact, 1, VectorTools::Linfty_norm));
+  expected["u_L2"] = (error(dh, sol, exact, 0, VectorTools::L2_norm) +
+                      error(dh, sol, exact, 1, VectorTools::L2_norm));
+  expected["u_W1infty"] = std::max(error(dh, sol, exact, 0, VectorTools::W1infty_norm),
+                                   error(dh, sol, exact, 1, VectorTools::W1infty_norm));
+  expected["u_H1"] = (error(dh, sol, exact, 0, VectorTools::H1_norm) +
+                      error(dh, sol, exact, 1, VectorTools::H1_norm));
+  expected["p_Linfty"] = error(dh, sol, exact, 2, VectorTools::Linfty_norm);
+  expected["p_L2"] = error(dh, sol, exact, 2, VectorTools::L2_norm);
+
+  // The table has a line with the names of the columns, and one with
+  // the errors
+  std::stringstream table;
+  eh.output_table(table);
+  std::string names_line, values_line;
+  std::getline(table, names_line);
+  std::getline(table, values_line);
+  std::istringstream names(names_line), errors(values_line);
+
+  std::string name;
+  double value;
+  while (names >> name && errors >> value)
+    deallog << name << ": "
+            << (std::abs(value - expected[name]) <= 1e-10*expected[name] ?
+                "true" : "false") << std::endl;
+}
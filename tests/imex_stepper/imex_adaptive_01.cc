@@ -0,0 +1,101 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Solve y' = -10 y with adaptive implicit Euler steps, bounded by 0.1:
+// the steps are small during the transient and grow as the solution
+// decays, while the error stays close to the tolerance.
+
+#include "../tests.h"
+
+#include <deal2lkit/imex_stepper.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/utilities.h>
+
+#include <deal.II/lac/block_vector.h>
+
+using namespace deal2lkit;
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  initlog();
+
+  typedef BlockVector<double> VEC;
+
+  IMEXStepper<VEC> imex("IMEX Stepper");
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/imex_adaptive_01.prm",
+                                "used_parameters.prm");
+
+  const double lambda = 10.0;
+  double jacobian = 0;
+  std::vector<double> times;
+  double max_error = 0;
+
+  imex.create_new_vector = [] ()
+  {
+    return SP(new VEC(1, 1));
+  };
+
+  imex.residual = [&] (const double, const VEC &y, const VEC &y_dot, VEC &res)
+  {
+    res[0] = y_dot[0] + lambda*y[0];
+    return 0;
+  };
+
+  imex.setup_jacobian = [&] (const double, const VEC &, const VEC &,
+                             const double alpha)
+  {
+    jacobian = alpha + lambda;
+    return 0;
+  };
+
+  imex.solve_jacobian_system = [&] (const VEC &rhs, VEC &dst)
+  {
+    dst[0] = rhs[0]/jacobian;
+    return 0;
+  };
+
+  imex.output_step = [&] (const double t, const VEC &y, const VEC &,
+                          const unsigned int)
+  {
+    if (times.empty() || t > times.back())
+      times.push_back(t);
+    max_error = std::max(max_error, std::abs(y[0] - std::exp(-lambda*t)));
+  };
+
+  imex.solver_should_restart = [] (const double, VEC &, VEC &)
+  {
+    return false;
+  };
+
+  VEC y(1, 1), y_dot(1, 1);
+  y = 1.0;
+  y_dot = -lambda;
+  imex.solve_dae(y, y_dot);
+
+  double min_step = 1.0;
+  double max_step = 0.0;
+  for (unsigned int i=1; i<times.size(); ++i)
+    {
+      min_step = std::min(min_step, times[i] - times[i-1]);
+      max_step = std::max(max_step, times[i] - times[i-1]);
+    }
+
+  deallog << "Steps: " << times.size()-1 << std::endl
+          << std::scientific << std::setprecision(2)
+          << "Smallest step: " << min_step << std::endl
+          << "Largest step: " << max_step << std::endl
+          << "Error: " << max_error << std::endl;
+}
@@ -0,0 +1,126 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Solve y' = -y + s(t) + y^2, with the explicit term y^2, up to t = 1/2
+// with sbdf2 saving checkpoints, and resume from the last one up to
+// t = 1. The checkpoint contains the history of the multistep scheme,
+// so the result must be the one of a run without interruption.
+
+#include "../tests.h"
+
+#include <deal2lkit/imex_stepper.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/utilities.h>
+
+#include <deal.II/lac/block_vector.h>
+
+using namespace deal2lkit;
+
+typedef BlockVector<double> VEC;
+
+void set_parameters(const std::string &final_time,
+                    const std::string &checkpoint_interval,
+                    const std::string &resume)
+{
+  ParameterHandler &prm = ParameterAcceptor::prm;
+  prm.enter_subsection("IMEX Stepper");
+  prm.set("Final time", final_time);
+  prm.set("Checkpoint interval (wall seconds)", checkpoint_interval);
+  prm.set("Resume from checkpoint", resume);
+  prm.leave_subsection();
+  ParameterAcceptor::parse_all_parameters();
+}
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  initlog();
+
+  IMEXStepper<VEC> imex("IMEX Stepper");
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/imex_checkpoint_01.prm",
+                                "used_parameters.prm");
+
+  double jacobian = 0;
+  std::vector<double> output_times;
+
+  imex.create_new_vector = [] ()
+  {
+    return SP(new VEC(1, 1));
+  };
+
+  imex.residual = [] (const double t, const VEC &y, const VEC &y_dot, VEC &res)
+  {
+    res[0] = y_dot[0] + y[0] - std::cos(t) + std::sin(t) + std::cos(t)*std::cos(t);
+    return 0;
+  };
+
+  imex.explicit_operator = [] (const double, const VEC &y, VEC &dst)
+  {
+    dst[0] = y[0]*y[0];
+    return 0;
+  };
+
+  imex.setup_jacobian = [&] (const double, const VEC &, const VEC &,
+                             const double alpha)
+  {
+    jacobian = alpha + 1.0;
+    return 0;
+  };
+
+  imex.solve_jacobian_system = [&] (const VEC &rhs, VEC &dst)
+  {
+    dst[0] = rhs[0]/jacobian;
+    return 0;
+  };
+
+  imex.output_step = [&] (const double t, const VEC &, const VEC &,
+                          const unsigned int)
+  {
+    output_times.push_back(t);
+  };
+
+  imex.solver_should_restart = [] (const double, VEC &, VEC &)
+  {
+    return false;
+  };
+
+  // Run without interruption
+  VEC y(1, 1), y_dot(1, 1);
+  y = 1.0;
+  y_dot = 0.0;
+  imex.solve_dae(y, y_dot);
+  const double uninterrupted = y[0];
+
+  // Stop in the middle, saving a checkpoint after each step
+  set_parameters("0.5", "1e-9", "false");
+  y = 1.0;
+  y_dot = 0.0;
+  imex.solve_dae(y, y_dot);
+
+  // Continue from the last checkpoint
+  set_parameters("1", "0", "true");
+  output_times.clear();
+  y = 0.0;
+  y_dot = 0.0;
+  imex.solve_dae(y, y_dot);
+
+  deallog << "Outputs after resuming: " << output_times.size() << std::endl
+          << "First output after resuming: " << output_times.front() << std::endl
+          << "Last output after resuming: " << output_times.back() << std::endl
+          << "Same solution as without interruption: "
+          << (std::abs(y[0] - uninterrupted) < 1e-12 ? "true" : "false") << std::endl
+          << std::scientific << std::setprecision(2)
+          << "Error: " << std::abs(y[0] - std::cos(1.0)) << std::endl;
+}
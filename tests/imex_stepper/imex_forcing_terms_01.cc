@@ -0,0 +1,100 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Solve y' = 1 - y^2 with the inexact Newton method of IMEXStepper. The
+// linear systems are solved only up to the tolerance given by the
+// Eisenstat-Walker forcing terms, which must start from the maximum
+// forcing term and become tighter as the Newton method converges.
+
+#include "../tests.h"
+
+#include <deal2lkit/imex_stepper.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/utilities.h>
+
+#include <deal.II/lac/block_vector.h>
+
+#include <algorithm>
+
+using namespace deal2lkit;
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  initlog();
+
+  typedef BlockVector<double> VEC;
+
+  IMEXStepper<VEC> imex("IMEX Stepper");
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/imex_forcing_terms_01.prm",
+                                "used_parameters.prm");
+
+  double jacobian = 0;
+  std::vector<double> tolerances;
+  double error = 1.0;
+
+  imex.create_new_vector = [] ()
+  {
+    return SP(new VEC(1, 1));
+  };
+
+  imex.residual = [] (const double, const VEC &y, const VEC &y_dot, VEC &res)
+  {
+    res[0] = y_dot[0] + y[0]*y[0] - 1.0;
+    return 0;
+  };
+
+  imex.setup_jacobian = [&] (const double, const VEC &y, const VEC &,
+                             const double alpha)
+  {
+    jacobian = alpha + 2.0*y[0];
+    return 0;
+  };
+
+  // An iterative solver stopped at the relative residual tolerance/2
+  imex.solve_jacobian_system_with_tolerance = [&] (const VEC &rhs, VEC &dst,
+                                                   const double tolerance)
+  {
+    tolerances.push_back(tolerance);
+    dst[0] = (1.0 - 0.5*tolerance)*rhs[0]/jacobian;
+    return 0;
+  };
+
+  imex.output_step = [&] (const double t, const VEC &y, const VEC &,
+                          const unsigned int)
+  {
+    if (std::abs(t - 1.0) < 1e-10)
+      error = std::abs(y[0] - std::tanh(1.0 + std::atanh(0.5)));
+  };
+
+  imex.solver_should_restart = [] (const double, VEC &, VEC &)
+  {
+    return false;
+  };
+
+  VEC y(1, 1), y_dot(1, 1);
+  y = 0.5;
+  y_dot = 0.75;
+  imex.solve_dae(y, y_dot);
+
+  const double min_tolerance = *std::min_element(tolerances.begin(), tolerances.end());
+  const double max_tolerance = *std::max_element(tolerances.begin(), tolerances.end());
+
+  deallog << "Linear solves: " << tolerances.size() << std::endl
+          << std::scientific << std::setprecision(2)
+          << "Smallest tolerance: " << min_tolerance << std::endl
+          << "Largest tolerance: " << max_tolerance << std::endl
+          << "Error: " << error << std::endl;
+}
@@ -0,0 +1,104 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Solve y' = 1 - y^2 with and without lagging the Jacobian across the
+// time steps: the lagged Jacobian must be set up fewer times, and give
+// the same solution.
+
+#include "../tests.h"
+
+#include <deal2lkit/imex_stepper.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/utilities.h>
+
+#include <deal.II/lac/block_vector.h>
+
+using namespace deal2lkit;
+
+typedef BlockVector<double> VEC;
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  initlog();
+
+  IMEXStepper<VEC> imex("IMEX Stepper");
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/imex_lag_jacobian_01.prm",
+                                "used_parameters.prm");
+
+  double jacobian = 0;
+  unsigned int n_setups = 0;
+
+  imex.create_new_vector = [] ()
+  {
+    return SP(new VEC(1, 1));
+  };
+
+  imex.residual = [] (const double, const VEC &y, const VEC &y_dot, VEC &res)
+  {
+    res[0] = y_dot[0] + y[0]*y[0] - 1.0;
+    return 0;
+  };
+
+  imex.setup_jacobian = [&] (const double, const VEC &y, const VEC &,
+                             const double alpha)
+  {
+    ++n_setups;
+    jacobian = alpha + 2.0*y[0];
+    return 0;
+  };
+
+  imex.solve_jacobian_system = [&] (const VEC &rhs, VEC &dst)
+  {
+    dst[0] = rhs[0]/jacobian;
+    return 0;
+  };
+
+  imex.output_step = [] (const double, const VEC &, const VEC &,
+                         const unsigned int)
+  {};
+
+  imex.solver_should_restart = [] (const double, VEC &, VEC &)
+  {
+    return false;
+  };
+
+  std::vector<unsigned int> setups;
+  std::vector<double> solutions;
+  for (const std::string lag : {"false", "true"})
+    {
+      ParameterHandler &prm = ParameterAcceptor::prm;
+      prm.enter_subsection("IMEX Stepper");
+      prm.set("Lag Jacobian based on convergence rate", lag);
+      prm.leave_subsection();
+      ParameterAcceptor::parse_all_parameters();
+
+      VEC y(1, 1), y_dot(1, 1);
+      y = 0.5;
+      y_dot = 0.75;
+      n_setups = 0;
+      imex.solve_dae(y, y_dot);
+      setups.push_back(n_setups);
+      solutions.push_back(y[0]);
+    }
+
+  deallog << "Jacobian setups without lagging: " << setups[0] << std::endl
+          << "Jacobian setups with lagging: " << setups[1] << std::endl
+          << "Same solution: "
+          << (std::abs(solutions[1] - solutions[0]) < 1e-8 ? "true" : "false") << std::endl
+          << std::scientific << std::setprecision(2)
+          << "Error: " << std::abs(solutions[1] - std::tanh(1.0 + std::atanh(0.5)))
+          << std::endl;
+}
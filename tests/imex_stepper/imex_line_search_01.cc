@@ -0,0 +1,88 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Solve the stationary problem atan(y - 2) = 0 starting from y = 0,
+// where the full Newton steps diverge. The interpolating line search
+// must shorten the first step, and then converge to y = 2.
+
+#include "../tests.h"
+
+#include <deal2lkit/imex_stepper.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/utilities.h>
+
+#include <deal.II/lac/block_vector.h>
+
+using namespace deal2lkit;
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  initlog();
+
+  typedef BlockVector<double> VEC;
+
+  IMEXStepper<VEC> imex("IMEX Stepper");
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/imex_line_search_01.prm",
+                                "used_parameters.prm");
+
+  double jacobian = 0;
+  double solution = 0;
+  unsigned int n_setups = 0;
+
+  imex.create_new_vector = [] ()
+  {
+    return SP(new VEC(1, 1));
+  };
+
+  imex.residual = [] (const double, const VEC &y, const VEC &, VEC &res)
+  {
+    res[0] = std::atan(y[0] - 2.0);
+    return 0;
+  };
+
+  imex.setup_jacobian = [&] (const double, const VEC &y, const VEC &,
+                             const double)
+  {
+    ++n_setups;
+    jacobian = 1.0/(1.0 + (y[0] - 2.0)*(y[0] - 2.0));
+    return 0;
+  };
+
+  imex.solve_jacobian_system = [&] (const VEC &rhs, VEC &dst)
+  {
+    dst[0] = rhs[0]/jacobian;
+    return 0;
+  };
+
+  imex.output_step = [&] (const double, const VEC &y, const VEC &,
+                          const unsigned int)
+  {
+    solution = y[0];
+  };
+
+  imex.solver_should_restart = [] (const double, VEC &, VEC &)
+  {
+    return false;
+  };
+
+  VEC y(1, 1), y_dot(1, 1);
+  y = 0.0;
+  y_dot = 0.0;
+  imex.solve_dae(y, y_dot);
+
+  deallog << "Solution: " << solution << std::endl
+          << "Jacobian setups: " << n_setups << std::endl;
+}
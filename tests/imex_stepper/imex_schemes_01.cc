@@ -0,0 +1,134 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Solve y' = -y + s(t) + y^2, whose solution is y = cos(t), with the
+// time stepping schemes of IMEXStepper. The term y^2 is explicit,
+// except with bdf2. The convergence order is computed from the errors
+// at t = 1 with two step sizes.
+
+#include "../tests.h"
+
+#include <deal2lkit/imex_stepper.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/utilities.h>
+
+#include <deal.II/lac/block_vector.h>
+
+using namespace deal2lkit;
+
+typedef BlockVector<double> VEC;
+
+double source(const double t)
+{
+  return std::cos(t) - std::sin(t) - std::cos(t)*std::cos(t);
+}
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  initlog();
+
+  IMEXStepper<VEC> imex("IMEX Stepper");
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/imex_schemes_01.prm",
+                                "used_parameters.prm");
+
+  bool fully_implicit = false;
+  double jacobian = 0;
+  double error = 0;
+
+  imex.create_new_vector = [] ()
+  {
+    return SP(new VEC(1, 1));
+  };
+
+  imex.residual = [&] (const double t, const VEC &y, const VEC &y_dot, VEC &res)
+  {
+    res[0] = y_dot[0] + y[0] - source(t);
+    if (fully_implicit)
+      res[0] -= y[0]*y[0];
+    return 0;
+  };
+
+  imex.setup_jacobian = [&] (const double, const VEC &y, const VEC &,
+                             const double alpha)
+  {
+    jacobian = alpha + 1.0;
+    if (fully_implicit)
+      jacobian -= 2.0*y[0];
+    return 0;
+  };
+
+  imex.solve_jacobian_system = [&] (const VEC &rhs, VEC &dst)
+  {
+    dst[0] = rhs[0]/jacobian;
+    return 0;
+  };
+
+  imex.output_step = [&] (const double t, const VEC &y, const VEC &,
+                          const unsigned int)
+  {
+    if (std::abs(t - 1.0) < 1e-10)
+      error = std::abs(y[0] - std::cos(1.0));
+  };
+
+  imex.solver_should_restart = [] (const double, VEC &, VEC &)
+  {
+    return false;
+  };
+
+  std::function<int(const double, const VEC &, VEC &)> square =
+    [] (const double, const VEC &y, VEC &dst)
+  {
+    dst[0] = y[0]*y[0];
+    return 0;
+  };
+
+  const std::vector<std::string> schemes = {"ars222", "ars443", "bdf2", "sbdf2"};
+  const std::vector<std::string> step_sizes = {"0.03125", "0.015625"};
+
+  deallog << std::scientific << std::setprecision(2);
+  for (const auto &scheme : schemes)
+    {
+      fully_implicit = (scheme == "bdf2");
+      if (fully_implicit)
+        imex.explicit_operator = nullptr;
+      else
+        imex.explicit_operator = square;
+
+      std::vector<double> errors;
+      for (const auto &step_size : step_sizes)
+        {
+          ParameterHandler &prm = ParameterAcceptor::prm;
+          prm.enter_subsection("IMEX Stepper");
+          prm.set("Time stepping scheme", scheme);
+          prm.set("Step size", step_size);
+          prm.leave_subsection();
+          ParameterAcceptor::parse_all_parameters();
+
+          VEC y(1, 1), y_dot(1, 1);
+          y = 1.0;
+          y_dot = 0.0;
+          error = 1.0;
+          imex.solve_dae(y, y_dot);
+          errors.push_back(error);
+        }
+
+      deallog << scheme << " errors: "
+              << errors[0] << " " << errors[1]
+              << ", convergence order: "
+              << static_cast<int>(std::round(std::log2(errors[0]/errors[1])))
+              << std::endl;
+    }
+}
@@ -0,0 +1,109 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Solve u_0 = cos(u_0), u_1 = cos(u_1)/2 with the Anderson accelerated
+// fixed-point iteration of KINSOL, and u_i^2 = i+2 with the Picard
+// iteration, whose operator is set up only at the initial guess.
+
+#include "../tests.h"
+
+#include <deal2lkit/kinsol_interface.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/utilities.h>
+
+#include <deal.II/lac/block_vector.h>
+
+using namespace deal2lkit;
+
+typedef BlockVector<double> VEC;
+
+void set_strategy(const std::string &strategy)
+{
+  ParameterHandler &prm = ParameterAcceptor::prm;
+  prm.enter_subsection("KINSOL");
+  prm.set("Strategy", strategy);
+  prm.leave_subsection();
+  ParameterAcceptor::parse_all_parameters();
+}
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  initlog();
+
+  KINSOLInterface<VEC> kinsol("KINSOL");
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/kinsol_anderson_01.prm",
+                                "used_parameters.prm");
+
+  kinsol.create_new_vector = [] ()
+  {
+    return SP(new VEC(1, 2));
+  };
+
+  // With the fixed_point strategy, residual() is the fixed-point function
+  set_strategy("fixed_point");
+  kinsol.residual = [] (const VEC &u, VEC &g)
+  {
+    g[0] = std::cos(u[0]);
+    g[1] = 0.5*std::cos(u[1]);
+    return 0;
+  };
+
+  VEC u(1, 2);
+  u = 1.0;
+  kinsol.initialize_solver(u);
+  kinsol.solve(u);
+
+  deallog << "fixed_point" << std::endl
+          << "Solution: " << u[0] << " " << u[1] << std::endl;
+
+  // Picard iteration with the operator 2 u_0, where u_0 is the
+  // initial guess
+  set_strategy("picard");
+  VEC op(1, 2);
+
+  kinsol.residual = [] (const VEC &u, VEC &res)
+  {
+    for (unsigned int i=0; i<2; ++i)
+      res[i] = u[i]*u[i] - (i + 2.0);
+    return 0;
+  };
+
+  kinsol.setup_jacobian = [&] (const VEC &u)
+  {
+    for (unsigned int i=0; i<2; ++i)
+      op[i] = 2.0*u[i];
+    return 0;
+  };
+
+  kinsol.solve_linear_system = [&] (const VEC &res, VEC &dst)
+  {
+    for (unsigned int i=0; i<2; ++i)
+      dst[i] = -res[i]/op[i];
+    return 0;
+  };
+
+  u = 1.0;
+  kinsol.initialize_solver(u);
+  kinsol.solve(u);
+
+  const KINSOLStatistics &statistics = kinsol.get_statistics();
+  deallog << "picard" << std::endl
+          << "Solution: " << u[0] << " " << u[1] << std::endl
+          << "Operator set up less often than the iterations: "
+          << (statistics.setup_jacobian.n_calls <
+              (unsigned long int)statistics.n_nonlinear_iterations ? "true" : "false")
+          << std::endl;
+}
@@ -0,0 +1,111 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Solve u_i^2 = i+2 with the Jacobian-free Newton-Krylov method of
+// KINSOL: first with difference quotients of residual(), and then with
+// the products computed by jacobian_vmult(). Only the preconditioner
+// is provided, and solve_linear_system() is never called.
+
+#include "../tests.h"
+
+#include <deal2lkit/kinsol_interface.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/utilities.h>
+
+#include <deal.II/lac/block_vector.h>
+
+using namespace deal2lkit;
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  initlog();
+
+  typedef BlockVector<double> VEC;
+
+  KINSOLInterface<VEC> kinsol("KINSOL");
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/kinsol_jfnk_01.prm",
+                                "used_parameters.prm");
+
+  VEC preconditioner(1, 2);
+  VEC jacobian(1, 2);
+
+  kinsol.create_new_vector = [] ()
+  {
+    return SP(new VEC(1, 2));
+  };
+
+  kinsol.residual = [] (const VEC &u, VEC &res)
+  {
+    for (unsigned int i=0; i<2; ++i)
+      res[i] = u[i]*u[i] - (i + 2.0);
+    return 0;
+  };
+
+  kinsol.setup_preconditioner = [&] (const VEC &u)
+  {
+    for (unsigned int i=0; i<2; ++i)
+      preconditioner[i] = 2.0*u[i];
+    return 0;
+  };
+
+  kinsol.solve_preconditioner = [&] (const VEC &rhs, VEC &dst)
+  {
+    for (unsigned int i=0; i<2; ++i)
+      dst[i] = rhs[i]/preconditioner[i];
+    return 0;
+  };
+
+  for (const std::string product : {"difference_quotient", "user"})
+    {
+      ParameterHandler &prm = ParameterAcceptor::prm;
+      prm.enter_subsection("KINSOL");
+      prm.set("Jacobian times vector product", product);
+      prm.leave_subsection();
+      ParameterAcceptor::parse_all_parameters();
+
+      if (product == "user")
+        {
+          kinsol.setup_jacobian = [&] (const VEC &u)
+          {
+            for (unsigned int i=0; i<2; ++i)
+              jacobian[i] = 2.0*u[i];
+            return 0;
+          };
+
+          kinsol.jacobian_vmult = [&] (const VEC &src, VEC &dst)
+          {
+            for (unsigned int i=0; i<2; ++i)
+              dst[i] = jacobian[i]*src[i];
+            return 0;
+          };
+        }
+
+      VEC u(1, 2);
+      u = 1.0;
+      kinsol.initialize_solver(u);
+      kinsol.solve(u);
+
+      const KINSOLStatistics &statistics = kinsol.get_statistics();
+      deallog << product << std::endl
+              << "Solution: " << u[0] << " " << u[1] << std::endl
+              << "Preconditioner applied: "
+              << (statistics.solve_preconditioner.n_calls > 0 ? "true" : "false")
+              << std::endl
+              << "Products with jacobian_vmult(): "
+              << (statistics.jacobian_vmult.n_calls > 0 ? "true" : "false")
+              << std::endl;
+    }
+}
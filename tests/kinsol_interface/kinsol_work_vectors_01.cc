@@ -0,0 +1,89 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Solve u_i^2 = i+2 with the Newton method of KINSOL. The callbacks
+// must always receive the work vectors of the solver, and, with exact
+// linear solves, jacobian_vmult() must never be called.
+
+#include "../tests.h"
+
+#include <deal2lkit/kinsol_interface.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/utilities.h>
+
+#include <deal.II/lac/block_vector.h>
+
+using namespace deal2lkit;
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  initlog();
+
+  typedef BlockVector<double> VEC;
+
+  KINSOLInterface<VEC> kinsol("KINSOL");
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/kinsol_work_vectors_01.prm",
+                                "used_parameters.prm");
+
+  VEC jacobian(1, 2);
+  bool work_vectors_used = true;
+
+  kinsol.create_new_vector = [] ()
+  {
+    return SP(new VEC(1, 2));
+  };
+
+  kinsol.residual = [&] (const VEC &u, VEC &res)
+  {
+    work_vectors_used = work_vectors_used &&
+                        &u == &kinsol.get_work_vector(KINSOLInterface<VEC>::work_y) &&
+                        &res == &kinsol.get_work_vector(KINSOLInterface<VEC>::work_residual);
+    for (unsigned int i=0; i<2; ++i)
+      res[i] = u[i]*u[i] - (i + 2.0);
+    return 0;
+  };
+
+  kinsol.setup_jacobian = [&] (const VEC &u)
+  {
+    work_vectors_used = work_vectors_used &&
+                        &u == &kinsol.get_work_vector(KINSOLInterface<VEC>::work_y);
+    for (unsigned int i=0; i<2; ++i)
+      jacobian[i] = 2.0*u[i];
+    return 0;
+  };
+
+  kinsol.solve_linear_system = [&] (const VEC &res, VEC &dst)
+  {
+    work_vectors_used = work_vectors_used &&
+                        &res == &kinsol.get_work_vector(KINSOLInterface<VEC>::work_residual) &&
+                        &dst == &kinsol.get_work_vector(KINSOLInterface<VEC>::work_update);
+    for (unsigned int i=0; i<2; ++i)
+      dst[i] = -res[i]/jacobian[i];
+    return 0;
+  };
+
+  VEC u(1, 2);
+  u = 1.0;
+  kinsol.initialize_solver(u);
+  kinsol.solve(u);
+
+  const KINSOLStatistics &statistics = kinsol.get_statistics();
+  deallog << "Solution: " << u[0] << " " << u[1] << std::endl
+          << "Callbacks on the work vectors: "
+          << (work_vectors_used ? "true" : "false") << std::endl
+          << "Products with the Jacobian: "
+          << statistics.jacobian_vmult.n_calls << std::endl;
+}
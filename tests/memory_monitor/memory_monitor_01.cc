@@ -0,0 +1,55 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Test the memory of the vector pool, and the summary of the memory
+// monitor with the memory of some components
+
+#include "../tests.h"
+#include <deal2lkit/memory_monitor.h>
+#include <deal2lkit/vector_pool.h>
+#include <deal.II/lac/vector.h>
+
+using namespace deal2lkit;
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+
+  initlog();
+
+  Vector<double> model(1024*1024);
+  auto create_new_vector = [] ()
+  {
+    return SP(new Vector<double>(1024*1024));
+  };
+
+  VectorPool<Vector<double> > &pool = VectorPool<Vector<double> >::get_pool();
+  {
+    auto a = pool.get(model, create_new_vector);
+    auto b = pool.get(model, create_new_vector);
+  }
+
+  deallog << "Pool memory: "
+          << (pool.memory_consumption() >= 2*sizeof(double)*model.size())
+          << std::endl;
+
+  MemoryMonitor memory(MPI_COMM_WORLD);
+  memory.add_component("Buffer", 3*1024*1024);
+  memory.add_component("Matrix", 512*1024);
+  memory.print_summary(deallog.get_file_stream());
+
+  pool.release_unused();
+  deallog << "After release: " << pool.memory_consumption() << std::endl;
+}
@@ -0,0 +1,76 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Test that the output queue runs the tasks in order, never holds more
+// than the maximum number of pending tasks, and rethrows exceptions
+
+#include "../tests.h"
+#include <deal2lkit/output_queue.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace deal2lkit;
+
+int main ()
+{
+  initlog();
+
+  OutputQueue queue(2);
+
+  std::vector<unsigned int> steps;
+  unsigned int max_pending = 0;
+  for (unsigned int i=0; i<6; ++i)
+    {
+      queue.push([&steps, i] ()
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        steps.push_back(i);
+      });
+      max_pending = std::max(max_pending, queue.n_pending());
+    }
+  queue.wait();
+
+  deallog << "Steps:";
+  for (auto s : steps)
+    deallog << " " << s;
+  deallog << std::endl;
+  deallog << "Maximum pending: " << max_pending
+          << ", pending after wait: " << queue.n_pending() << std::endl;
+
+  queue.push([] ()
+  {
+    throw std::runtime_error("output failed");
+  });
+  try
+    {
+      queue.wait();
+    }
+  catch (std::exception &e)
+    {
+      deallog << "Caught: " << e.what() << std::endl;
+    }
+
+  // Without pending tasks, they are run immediately
+  queue.set_max_pending(0);
+  queue.push([&steps] ()
+  {
+    steps.push_back(6);
+  });
+  deallog << "Synchronous step: " << steps.back() << std::endl;
+}
@@ -0,0 +1,85 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Evaluate two linear functions at some probe points, refine the mesh,
+// and evaluate them again
+
+#include "../tests.h"
+#include <deal2lkit/parsed_point_probe.h>
+
+#include <deal.II/base/function_parser.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/numerics/vector_tools.h>
+
+using namespace deal2lkit;
+
+int main ()
+{
+  initlog();
+
+  std::vector<Point<2> > points;
+  points.push_back(Point<2>(.1, .2));
+  points.push_back(Point<2>(.5, .5));
+  points.push_back(Point<2>(.9, .95));
+  points.push_back(Point<2>(2, 2));
+
+  ParsedPointProbe<2> probe("Probe", points);
+  ParameterAcceptor::initialize();
+
+  Triangulation<2> tria;
+  GridGenerator::hyper_cube(tria);
+  tria.refine_global(3);
+
+  FE_Q<2> fe(1);
+  DoFHandler<2> dh(tria);
+
+  std::map<std::string,double> constants;
+  FunctionParser<2> f(1);
+  FunctionParser<2> g(1);
+  f.initialize("x,y", "x+2*y", constants);
+  g.initialize("x,y", "3*x-y", constants);
+
+  for (unsigned int cycle=0; cycle<2; ++cycle)
+    {
+      dh.distribute_dofs(fe);
+      Vector<double> u(dh.n_dofs());
+      Vector<double> v(dh.n_dofs());
+      VectorTools::interpolate(dh, f, u);
+      VectorTools::interpolate(dh, g, v);
+
+      if (cycle == 0)
+        probe.locate(dh);
+
+      std::vector<const Vector<double> *> vectors;
+      vectors.push_back(&u);
+      vectors.push_back(&v);
+
+      std::vector<std::vector<Vector<double> > > values;
+      probe.evaluate(vectors, values);
+
+      deallog << "Cycle " << cycle << ", located: " << probe.is_located() << std::endl;
+      for (unsigned int i=0; i<points.size(); ++i)
+        deallog << "P: " << points[i]
+                << ", found: " << probe.is_found(i)
+                << ", u: " << values[0][i][0]
+                << ", v: " << values[1][i][0] << std::endl;
+
+      tria.refine_global(1);
+      deallog << "After refinement, located: " << probe.is_located() << std::endl;
+    }
+}
@@ -0,0 +1,67 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Test that the profiler counts nested scopes, merges the threads, and
+// ignores the scopes entered while it is disabled
+
+#include "../tests.h"
+#include <deal2lkit/profiler.h>
+
+#include <thread>
+
+using namespace deal2lkit;
+
+void inner()
+{
+  D2K_PROFILE_SCOPE("inner");
+}
+
+void outer(const unsigned int n)
+{
+  D2K_PROFILE_SCOPE("outer");
+  for (unsigned int i=0; i<n; ++i)
+    inner();
+}
+
+int main ()
+{
+  initlog();
+
+  outer(3);
+  deallog << "Disabled: " << Profiler::n_calls("outer") << std::endl;
+
+  Profiler::enable();
+  outer(3);
+  std::thread thread([] ()
+  {
+    outer(2);
+    outer(2);
+  });
+  thread.join();
+  inner();
+
+  deallog << "outer: " << Profiler::n_calls("outer")
+          << ", outer;inner: " << Profiler::n_calls("outer;inner")
+          << ", inner: " << Profiler::n_calls("inner") << std::endl;
+  deallog << "Time of outer includes inner: "
+          << (Profiler::total_time("outer") >= Profiler::total_time("outer;inner"))
+          << std::endl;
+
+  Profiler::reset();
+  outer(1);
+  deallog << "After reset: " << Profiler::n_calls("outer")
+          << " " << Profiler::n_calls("outer;inner") << std::endl;
+  Profiler::disable();
+}
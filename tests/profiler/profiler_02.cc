@@ -0,0 +1,55 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Test that the floating point operations are added to all the open
+// scopes when the hardware counters are enabled, and that the counters
+// never decrease, whether or not they are available on this machine
+
+#include "../tests.h"
+#include <deal2lkit/profiler.h>
+
+using namespace deal2lkit;
+
+void axpy(const unsigned int n)
+{
+  D2K_PROFILE_SCOPE("axpy");
+  Profiler::add_flops(2.0*n);
+}
+
+int main ()
+{
+  initlog();
+
+  Profiler::enable();
+  axpy(10);
+  deallog << "Without counters: " << Profiler::n_flops("axpy") << std::endl;
+
+  Profiler::reset();
+  Profiler::enable(false, 0, true);
+  {
+    D2K_PROFILE_SCOPE("solve");
+    Profiler::add_flops(1);
+    for (unsigned int i=0; i<3; ++i)
+      axpy(10);
+  }
+  deallog << "solve: " << Profiler::n_flops("solve")
+          << ", solve;axpy: " << Profiler::n_flops("solve;axpy") << std::endl;
+
+  bool non_negative = true;
+  for (unsigned int e=0; e<PerfCounters::n_events; ++e)
+    non_negative &= (Profiler::hardware_counter("solve", PerfCounters::Event(e)) >= 0);
+  deallog << "Non negative counts: " << non_negative << std::endl;
+  Profiler::disable();
+}
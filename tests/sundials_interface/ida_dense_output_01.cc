@@ -0,0 +1,127 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Solve y' = -y with dense output, and restart IDA in the middle of an
+// output interval: all the outputs must still be written at multiples
+// of the output period, after the restart too.
+
+#include "../tests.h"
+
+#include <deal2lkit/ida_interface.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/utilities.h>
+
+#include <deal.II/lac/block_vector.h>
+
+using namespace deal2lkit;
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  initlog();
+
+  typedef BlockVector<double> VEC;
+
+  IDAInterface<VEC> ida("IDA Solver Parameters");
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/ida_dense_output_01.prm",
+                                "used_parameters.prm");
+
+  const double period = 2e-2;
+  double alpha = 0;
+  VEC diff(1, 1);
+  diff = 1.0;
+
+  std::vector<double> output_times;
+  std::vector<double> output_values;
+  unsigned int n_restarts = 0;
+
+  ida.create_new_vector = [] ()
+  {
+    return SP(new VEC(1, 1));
+  };
+
+  ida.residual = [] (const double, const VEC &y, const VEC &y_dot, VEC &res)
+  {
+    res = y_dot;
+    res += y;
+    return 0;
+  };
+
+  ida.setup_jacobian = [&] (const double, const VEC &, const VEC &, const double a)
+  {
+    alpha = a;
+    return 0;
+  };
+
+  ida.solve_jacobian_system = [&] (const VEC &rhs, VEC &dst)
+  {
+    dst = rhs;
+    dst /= (alpha + 1.0);
+    return 0;
+  };
+
+  ida.output_step = [&] (const double t, const VEC &y, const VEC &,
+                         const unsigned int)
+  {
+    output_times.push_back(t);
+    output_values.push_back(y[0]);
+  };
+
+  ida.solver_should_restart = [&] (const double t, VEC &, VEC &)
+  {
+    if (n_restarts == 0 && t >= 0.5)
+      {
+        ++n_restarts;
+        return true;
+      }
+    return false;
+  };
+
+  ida.differential_components = [&] () -> VEC &
+  {
+    return diff;
+  };
+
+  VEC y(1, 1), y_dot(1, 1);
+  y = 1.0;
+  y_dot = -1.0;
+  ida.solve_dae(y, y_dot);
+
+  bool on_period = true;
+  bool increasing = true;
+  for (unsigned int i=0; i<output_times.size(); ++i)
+    {
+      const double k = output_times[i]/period;
+      on_period = on_period && std::abs(k - std::round(k)) < 1e-8;
+      if (i > 0)
+        increasing = increasing && output_times[i] > output_times[i-1];
+    }
+
+  deallog << "Restarts: " << n_restarts << std::endl
+          << "Outputs: " << output_times.size() << std::endl
+          << "Last output: " << output_times.back() << std::endl
+          << "Outputs at multiples of the period: "
+          << (on_period ? "true" : "false") << std::endl
+          << "Outputs increasing: "
+          << (increasing ? "true" : "false") << std::endl;
+
+  // The tight tolerances make the values exact to the digits shown
+  deallog << std::fixed << std::setprecision(4);
+  for (unsigned int i=0; i<output_times.size(); ++i)
+    if (std::abs(output_times[i] - 0.5) < 1e-8 ||
+        std::abs(output_times[i] - 1.0) < 1e-8)
+      deallog << "Solution at t = " << output_times[i] << ": "
+              << output_values[i] << std::endl;
+}
@@ -0,0 +1,126 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Solve y' = -y with the event y = 1/2: IDA must stop at t = log(2),
+// where solver_should_restart() is called, and nowhere else.
+
+#include "../tests.h"
+
+#include <deal2lkit/ida_interface.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/utilities.h>
+
+#include <deal.II/lac/block_vector.h>
+
+#include <iomanip>
+#include <sstream>
+
+using namespace deal2lkit;
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  initlog();
+
+  typedef BlockVector<double> VEC;
+
+  IDAInterface<VEC> ida("IDA Solver Parameters");
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/ida_events_01.prm",
+                                "used_parameters.prm");
+
+  double alpha = 0;
+  VEC diff(1, 1);
+  diff = 1.0;
+
+  std::vector<double> restart_times;
+  std::vector<int> directions;
+  double max_error = 0;
+
+  ida.create_new_vector = [] ()
+  {
+    return SP(new VEC(1, 1));
+  };
+
+  ida.residual = [] (const double, const VEC &y, const VEC &y_dot, VEC &res)
+  {
+    res = y_dot;
+    res += y;
+    return 0;
+  };
+
+  ida.setup_jacobian = [&] (const double, const VEC &, const VEC &, const double a)
+  {
+    alpha = a;
+    return 0;
+  };
+
+  ida.solve_jacobian_system = [&] (const VEC &rhs, VEC &dst)
+  {
+    dst = rhs;
+    dst /= (alpha + 1.0);
+    return 0;
+  };
+
+  ida.output_step = [&] (const double t, const VEC &y, const VEC &,
+                         const unsigned int)
+  {
+    max_error = std::max(max_error, std::abs(y[0] - std::exp(-t)));
+  };
+
+  ida.event_function = [] (const double, const VEC &y, const VEC &,
+                           std::vector<double> &values)
+  {
+    values[0] = y[0] - 0.5;
+    return 0;
+  };
+
+  // Restart once at the event
+  ida.solver_should_restart = [&] (const double t, VEC &, VEC &)
+  {
+    restart_times.push_back(t);
+    directions.push_back(ida.get_events_found()[0]);
+    return restart_times.size() == 1;
+  };
+
+  ida.differential_components = [&] () -> VEC &
+  {
+    return diff;
+  };
+
+  ida.set_n_events(1);
+
+  VEC y(1, 1), y_dot(1, 1);
+  y = 1.0;
+  y_dot = -1.0;
+  ida.solve_dae(y, y_dot);
+
+  bool at_event = true;
+  for (unsigned int i=1; i<restart_times.size(); ++i)
+    at_event = at_event && restart_times[i] == restart_times[0];
+
+  std::ostringstream event_time;
+  event_time << std::fixed << std::setprecision(4) << restart_times[0];
+
+  deallog << "Events counted by IDA: "
+          << ida.get_statistics().n_events << std::endl
+          << "Calls to solver_should_restart: "
+          << restart_times.size() << std::endl
+          << "All calls at the event: "
+          << (at_event ? "true" : "false") << std::endl
+          << "Event time: " << event_time.str() << std::endl
+          << "Event direction: " << directions[0] << std::endl
+          << "Error below 1e-4: "
+          << (max_error < 1e-4 ? "true" : "false") << std::endl;
+}
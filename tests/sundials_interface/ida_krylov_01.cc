@@ -0,0 +1,112 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Solve y_0' = -y_0, y_1' = -2 y_1 with the matrix-free GMRES of IDA:
+// only jacobian_vmult() and the preconditioner are provided, and
+// setup_jacobian() and solve_jacobian_system() are never called.
+
+#include "../tests.h"
+
+#include <deal2lkit/ida_interface.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/utilities.h>
+
+#include <deal.II/lac/block_vector.h>
+
+using namespace deal2lkit;
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  initlog();
+
+  typedef BlockVector<double> VEC;
+
+  IDAInterface<VEC> ida("IDA Solver Parameters");
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/ida_krylov_01.prm",
+                                "used_parameters.prm");
+
+  VEC diff(1, 2);
+  diff = 1.0;
+
+  unsigned int n_vmult = 0;
+  unsigned int n_preconditioner = 0;
+  double last_time = 0;
+  VEC last_solution(1, 2);
+
+  ida.create_new_vector = [] ()
+  {
+    return SP(new VEC(1, 2));
+  };
+
+  ida.residual = [] (const double, const VEC &y, const VEC &y_dot, VEC &res)
+  {
+    res[0] = y_dot[0] + y[0];
+    res[1] = y_dot[1] + 2.0*y[1];
+    return 0;
+  };
+
+  ida.jacobian_vmult = [&] (const double, const VEC &, const VEC &,
+                            const double alpha, const VEC &src, VEC &dst)
+  {
+    ++n_vmult;
+    dst[0] = (alpha + 1.0)*src[0];
+    dst[1] = (alpha + 2.0)*src[1];
+    return 0;
+  };
+
+  ida.solve_preconditioner = [&] (const double, const VEC &, const VEC &,
+                                  const double alpha, const VEC &rhs, VEC &dst)
+  {
+    ++n_preconditioner;
+    dst[0] = rhs[0]/(alpha + 1.0);
+    dst[1] = rhs[1]/(alpha + 2.0);
+    return 0;
+  };
+
+  ida.output_step = [&] (const double t, const VEC &y, const VEC &,
+                         const unsigned int)
+  {
+    last_time = t;
+    last_solution = y;
+  };
+
+  ida.solver_should_restart = [] (const double, VEC &, VEC &)
+  {
+    return false;
+  };
+
+  ida.differential_components = [&] () -> VEC &
+  {
+    return diff;
+  };
+
+  VEC y(1, 2), y_dot(1, 2);
+  y = 1.0;
+  y_dot[0] = -1.0;
+  y_dot[1] = -2.0;
+  ida.solve_dae(y, y_dot);
+
+  deallog << "Jacobian products: "
+          << (n_vmult > 0 ? "true" : "false") << std::endl
+          << "Preconditioner applications: "
+          << (n_preconditioner > 0 ? "true" : "false") << std::endl
+          << "Linear iterations counted: "
+          << (ida.get_statistics().n_linear_iterations > 0 ? "true" : "false") << std::endl;
+
+  deallog << std::fixed << std::setprecision(4)
+          << "Solution at t = " << last_time << ": "
+          << last_solution[0] << " " << last_solution[1] << std::endl;
+}
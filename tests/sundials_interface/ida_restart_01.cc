@@ -0,0 +1,118 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Solve y' = -y and restart IDA at five outputs. The layout of the
+// vectors does not change, so IDA is reinitialized in place and the
+// work vector of the linear solver is kept.
+
+#include "../tests.h"
+
+#include <deal2lkit/ida_interface.h>
+#include <deal2lkit/parameter_acceptor.h>
+#include <deal2lkit/utilities.h>
+
+#include <deal.II/lac/block_vector.h>
+
+using namespace deal2lkit;
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  initlog();
+
+  typedef BlockVector<double> VEC;
+
+  IDAInterface<VEC> ida("IDA Solver Parameters");
+  ParameterAcceptor::initialize(SOURCE_DIR "/parameters/ida_restart_01.prm",
+                                "used_parameters.prm");
+
+  double alpha = 0;
+  VEC diff(1, 1);
+  diff = 1.0;
+
+  unsigned int n_outputs = 0;
+  unsigned int n_restarts = 0;
+  double last_restart = -1;
+  double max_error = 0;
+  std::vector<const VEC *> work_vectors;
+
+  ida.create_new_vector = [] ()
+  {
+    return SP(new VEC(1, 1));
+  };
+
+  ida.residual = [] (const double, const VEC &y, const VEC &y_dot, VEC &res)
+  {
+    res = y_dot;
+    res += y;
+    return 0;
+  };
+
+  ida.setup_jacobian = [&] (const double, const VEC &, const VEC &, const double a)
+  {
+    alpha = a;
+    return 0;
+  };
+
+  ida.solve_jacobian_system = [&] (const VEC &rhs, VEC &dst)
+  {
+    dst = rhs;
+    dst /= (alpha + 1.0);
+    return 0;
+  };
+
+  ida.output_step = [&] (const double t, const VEC &y, const VEC &,
+                         const unsigned int)
+  {
+    ++n_outputs;
+    max_error = std::max(max_error, std::abs(y[0] - std::exp(-t)));
+  };
+
+  // Restart once at each output between 0.25 and 0.75
+  ida.solver_should_restart = [&] (const double t, VEC &, VEC &)
+  {
+    work_vectors.push_back(&ida.get_linear_solver_work_vector());
+    if (t >= 0.25 && t <= 0.75 && t != last_restart)
+      {
+        ++n_restarts;
+        last_restart = t;
+        return true;
+      }
+    return false;
+  };
+
+  ida.differential_components = [&] () -> VEC &
+  {
+    return diff;
+  };
+
+  VEC y(1, 1), y_dot(1, 1);
+  y = 1.0;
+  y_dot = -1.0;
+  ida.solve_dae(y, y_dot);
+
+  bool same_work_vector = true;
+  for (unsigned int i=1; i<work_vectors.size(); ++i)
+    same_work_vector = same_work_vector && work_vectors[i] == work_vectors[0];
+
+  deallog << "Restarts: " << n_restarts << std::endl
+          << "Restarts counted by IDA: "
+          << ida.get_statistics().n_restarts << std::endl
+          << "Outputs: " << n_outputs << std::endl
+          << "Work vector kept: "
+          << (same_work_vector ? "true" : "false") << std::endl
+          << "Error below 1e-4: "
+          << (max_error < 1e-4 ? "true" : "false") << std::endl;
+}
@@ -0,0 +1,54 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Test the printing and the differences of the solver statistics
+
+#include "../tests.h"
+#include <deal2lkit/sundials_statistics.h>
+
+using namespace deal2lkit;
+
+int main ()
+{
+  initlog();
+
+  IDAStatistics previous;
+  previous.n_steps = 10;
+  previous.n_residual_evaluations = 25;
+  previous.residual.n_calls = 25;
+  previous.residual.wall_time = 0.5;
+  previous.current_time = 1;
+
+  IDAStatistics current = previous;
+  current.n_steps = 16;
+  current.n_residual_evaluations = 40;
+  current.residual.n_calls = 40;
+  current.residual.wall_time = 0.75;
+  current.current_time = 2;
+  current.last_order = 2;
+
+  (current - previous).print_json(deallog.get_file_stream());
+
+  KINSOLStatistics first;
+  first.n_nonlinear_iterations = 3;
+  first.solve_linear_system.n_calls = 3;
+
+  KINSOLStatistics second;
+  second.n_nonlinear_iterations = 4;
+  second.solve_linear_system.n_calls = 4;
+  second.residual_norm = 0.125;
+
+  (first + second).print_table(deallog.get_file_stream(), "KINSOL");
+}
@@ -0,0 +1,106 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Test create_directory, copy_file and rename_file: nested directories,
+// destinations that are directories, and copies that are up to date.
+
+#include "../tests.h"
+#include <deal2lkit/utilities.h>
+
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <utime.h>
+
+using namespace deal2lkit;
+
+void write_file(const std::string &file, const std::string &content)
+{
+  std::ofstream out(file.c_str());
+  out << content;
+}
+
+std::string read_file(const std::string &file)
+{
+  std::ifstream in(file.c_str());
+  std::string content;
+  std::getline(in, content);
+  return content;
+}
+
+void set_modification_time(const std::string &file, const std::time_t time)
+{
+  struct utimbuf times;
+  times.actime = time;
+  times.modtime = time;
+  utime(file.c_str(), &times);
+}
+
+int main ()
+{
+  initlog();
+  const std::string base = "directory_01_test";
+  const std::time_t now = std::time(nullptr);
+
+  deallog << "Nested directory created: "
+          << (create_directory(base + "/a/b/c") ? "true" : "false") << std::endl;
+  deallog << "Existing directory created: "
+          << (create_directory(base + "/a/b") ? "true" : "false") << std::endl;
+
+  write_file(base + "/file.txt", "original");
+
+  // The destination is a directory: the copy keeps the name of the file
+  copy_file(base + "/file.txt", base + "/a/b/c");
+  deallog << "Copied into a directory: "
+          << (read_file(base + "/a/b/c/file.txt") == "original" ? "true" : "false")
+          << std::endl;
+
+  // A newer copy with the same size is not overwritten
+  write_file(base + "/a/b/c/file.txt", "modified");
+  set_modification_time(base + "/file.txt", now - 100);
+  set_modification_time(base + "/a/b/c/file.txt", now);
+  copy_file(base + "/file.txt", base + "/a/b/c/file.txt");
+  deallog << "Up to date copy skipped: "
+          << (read_file(base + "/a/b/c/file.txt") == "modified" ? "true" : "false")
+          << std::endl;
+
+  // An older copy is overwritten
+  set_modification_time(base + "/file.txt", now + 100);
+  copy_file(base + "/file.txt", base + "/a/b/c/file.txt");
+  deallog << "Outdated copy replaced: "
+          << (read_file(base + "/a/b/c/file.txt") == "original" ? "true" : "false")
+          << std::endl;
+
+  // Rename into a directory, and to a new name
+  rename_file(base + "/file.txt", base + "/a");
+  deallog << "Renamed into a directory: "
+          << (file_exists(base + "/a/file.txt") &&
+              !file_exists(base + "/file.txt") ? "true" : "false") << std::endl;
+
+  rename_file(base + "/a/file.txt", base + "/a/b/renamed.txt");
+  deallog << "Renamed: "
+          << (read_file(base + "/a/b/renamed.txt") == "original" &&
+              !file_exists(base + "/a/file.txt") ? "true" : "false") << std::endl;
+
+  // A copy on the file itself leaves it unchanged
+  copy_file(base + "/a/b/renamed.txt", base + "/a/b/");
+  deallog << "Copied on itself: "
+          << (read_file(base + "/a/b/renamed.txt") == "original" ? "true" : "false")
+          << std::endl;
+
+  const std::string cmd = "rm -rf " + base;
+  if (std::system(cmd.c_str()) != 0)
+    deallog << "Impossible to remove " + base + "." << std::endl;
+}
@@ -0,0 +1,58 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// This test is for the benchmark harness and the statistics of the
+// TimeUtilities class of utilities.h
+
+#include "../tests.h"
+#include <deal2lkit/utilities.h>
+
+
+using namespace deal2lkit;
+
+int main ()
+{
+  initlog();
+
+  TimeUtilities time_utilities;
+
+  unsigned int n_calls = 0;
+  const unsigned int n_measures = time_utilities.benchmark([&n_calls] ()
+  {
+    ++n_calls;
+  }, 2, 0.01, 5, 5);
+
+  deallog << "Calls: " << n_calls
+          << ", measures: " << n_measures
+          << ", stored: " << time_utilities.get_num_measures() << std::endl;
+
+  // Replace the measures with known values
+  for (unsigned int i=0; i<5; ++i)
+    time_utilities[i] = i+1;
+
+  deallog << "Min: " << time_utilities.get_min()
+          << ", median: " << time_utilities.get_median()
+          << ", p95: " << time_utilities.get_percentile(95)
+          << ", max: " << time_utilities.get_max() << std::endl;
+  deallog << "Mean: " << time_utilities.get_mean()
+          << ", confidence interval: " << time_utilities.get_confidence_interval()
+          << std::endl;
+
+  time_utilities.write_csv(deallog.get_file_stream(), "known");
+  time_utilities.write_json(deallog.get_file_stream(), "known");
+
+  time_utilities.clear();
+  deallog << "After clear: " << time_utilities.get_num_measures() << std::endl;
+}
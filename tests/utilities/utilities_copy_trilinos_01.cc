@@ -0,0 +1,101 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Copy vectors to an N_Vector and back, when the locally owned indices
+// are not a contiguous range: each process owns every second index of
+// each block.
+
+#include "../tests.h"
+#include <deal2lkit/utilities.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/lac/block_vector.h>
+#include <deal.II/lac/trilinos_block_vector.h>
+
+
+using namespace deal2lkit;
+
+
+int main (int argc, char *argv[])
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  mpi_initlog();
+
+  Assert(Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD) == 2, ExcNotImplemented());
+  const unsigned int rank = Utilities::MPI::this_mpi_process(MPI_COMM_WORLD);
+
+  IndexSet index;
+  index.set_size(6);
+  for (unsigned int i = rank; i<6; i+=2)
+    index.add_index(i);
+  index.compress();
+
+  std::vector<IndexSet> indices(2, index);
+  TrilinosWrappers::MPI::BlockVector v(indices, MPI_COMM_WORLD);
+  for (unsigned int b=0; b<2; ++b)
+    for (IndexSet::size_type i=0; i < index.n_elements(); ++i)
+      v.block(b)[index.nth_index_in_set(i)] = 10*b + index.nth_index_in_set(i);
+  v.compress(VectorOperation::insert);
+
+  N_Vector nv = N_VNew_Parallel(MPI_COMM_WORLD, 6, 12);
+
+  // The N_Vector has the owned entries of the first block, then those
+  // of the second one
+  copy(nv, v);
+  bool ordered = true;
+  for (unsigned int b=0; b<2; ++b)
+    for (IndexSet::size_type i=0; i < index.n_elements(); ++i)
+      if (NV_Ith_P(nv, 3*b+i) != 10*b + index.nth_index_in_set(i))
+        ordered = false;
+
+  TrilinosWrappers::MPI::BlockVector w(indices, MPI_COMM_WORLD);
+  copy(w, nv);
+  w -= v;
+  const bool block_round_trip = (w.l2_norm() == 0);
+
+  N_Vector nv_block = N_VNew_Parallel(MPI_COMM_WORLD, 3, 6);
+  copy(nv_block, v.block(1));
+  TrilinosWrappers::MPI::Vector u(index, MPI_COMM_WORLD);
+  copy(u, nv_block);
+  u -= v.block(1);
+  const bool vector_round_trip = (u.l2_norm() == 0);
+
+  BlockVector<double> s(2, 3), t(2, 3);
+  for (unsigned int i=0; i<s.size(); ++i)
+    s[i] = i + 1;
+  N_Vector nv_serial = N_VNew_Parallel(MPI_COMM_SELF, 6, 6);
+  copy(nv_serial, s);
+  copy(t, nv_serial);
+  t -= s;
+  const bool serial_round_trip = (t.l2_norm() == 0);
+
+  const unsigned int all_ordered =
+    Utilities::MPI::min(ordered ? 1u : 0u, MPI_COMM_WORLD);
+  const unsigned int all_serial_round_trip =
+    Utilities::MPI::min(serial_round_trip ? 1u : 0u, MPI_COMM_WORLD);
+
+  deallog << "Entries in the order of the owned indices: "
+          << (all_ordered == 1 ? "true" : "false") << std::endl;
+  deallog << "Block vector round trip: "
+          << (block_round_trip ? "true" : "false") << std::endl;
+  deallog << "Vector round trip: "
+          << (vector_round_trip ? "true" : "false") << std::endl;
+  deallog << "Serial block vector round trip: "
+          << (all_serial_round_trip == 1 ? "true" : "false") << std::endl;
+
+  N_VDestroy_Parallel(nv);
+  N_VDestroy_Parallel(nv_block);
+  N_VDestroy_Parallel(nv_serial);
+}
@@ -0,0 +1,72 @@
+//-----------------------------------------------------------
+//
+//    Copyright (C) 2016 by the deal2lkit authors
+//
+//    This file is part of the deal2lkit library.
+//
+//    The deal2lkit library is free software; you can use it, redistribute
+//    it, and/or modify it under the terms of the GNU Lesser General
+//    Public License as published by the Free Software Foundation; either
+//    version 2.1 of the License, or (at your option) any later version.
+//    The full text of the license can be found in the file LICENSE at
+//    the top level of the deal2lkit distribution.
+//
+//-----------------------------------------------------------
+
+// Test that the vector pool reuses vectors with the same layout
+
+#include "../tests.h"
+#include <deal2lkit/vector_pool.h>
+
+#include <deal.II/lac/block_vector.h>
+
+using namespace deal2lkit;
+
+int main ()
+{
+  initlog();
+
+  BlockVector<double> small(2, 3);
+  BlockVector<double> large(2, 5);
+  BlockVector<double> uneven(std::vector<types::global_dof_index> {4, 2});
+
+  std::function<shared_ptr<BlockVector<double> >()> create_small = [&] ()
+  {
+    return SP(new BlockVector<double>(small));
+  };
+  std::function<shared_ptr<BlockVector<double> >()> create_large = [&] ()
+  {
+    return SP(new BlockVector<double>(large));
+  };
+  std::function<shared_ptr<BlockVector<double> >()> create_uneven = [&] ()
+  {
+    return SP(new BlockVector<double>(uneven));
+  };
+
+  VectorPool<BlockVector<double> > &pool = VectorPool<BlockVector<double> >::get_pool();
+
+  for (unsigned int step=0; step<3; ++step)
+    {
+      auto a = pool.get(small, create_small);
+      auto b = pool.get(small, create_small);
+      (*a)(0) = 1.0;
+      deallog << "Step " << step
+              << ": allocations " << pool.n_allocations()
+              << ", unused " << pool.n_unused() << std::endl;
+    }
+
+  {
+    auto a = pool.get(large, create_large);
+    auto b = pool.get(uneven, create_uneven);
+    deallog << "Size " << a->size() << " and " << b->size()
+            << ": allocations " << pool.n_allocations() << std::endl;
+  }
+
+  auto c = pool.get(small, create_small);
+  deallog << "Reused vector is zero: " << (c->l2_norm() == 0 ? "true" : "false")
+          << ", unused " << pool.n_unused() << std::endl;
+
+  pool.release_unused();
+  deallog << "After release, unused " << pool.n_unused()
+          << ", allocations " << pool.n_allocations() << std::endl;
+}